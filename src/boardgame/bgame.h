@@ -16,10 +16,12 @@
 
 #include "bgtypes.h"
 #include "bgmove.h"
+#include "bgasync.h"
 #include "bgboard.h"
 #include "bgplayer.h"
 #include "bgplayers.h"
 #include "bgpiece.h"
+#include "bgstats.h"
 
 BG_BEGIN
 
@@ -73,10 +75,15 @@ namespace game
  * virtual bool IsDrawStateRecheck();
  *
  * @endcode
+ * @note every `playerid` is the player's seat in Players (0, 1, ... in insertion order)
+ * @note overrides of Apply, IsValid, IsWinning and GetPossibleMoves should start with
+ * `_ISSTAT_ stats::Count(stats::Enum::...)` so BG_STATS builds can count them
  * 
  * @tparam T
+ * @tparam B board type, a PBoard<T> unless given, e.g. SparseBoard<BNode<T>> for large sparse boards,
+ * the default is declared with the forward declaration in bgplayer.h
  */
-template <class T>
+template <class T, class B>
 class Game
 {
 public:
@@ -84,15 +91,15 @@ public:
 
   Game() = delete;
 
-  Game(size_t turning_player, const Players<T> &P, const PBoard<T> &B)
+  Game(size_t turning_player, const Players<T> &P, const B &board)
       : _turning_player{0}, _winner{-1}, _state{game::Enum::NOTOVER},
         _players{P.copy()},
-        _board{B.copy()} {}
+        _board{board.copy()} {}
 
-  Game(size_t turning_player, Players<T> &&P, PBoard<T> &&B)
+  Game(size_t turning_player, Players<T> &&P, B &&board)
       : _turning_player{0}, _winner{-1}, _state{game::Enum::NOTOVER},
         _players{P.move()},
-        _board{B.move()} {}
+        _board{board.move()} {}
 
   Game(const Game &other)
       : _turning_player{other._turning_player}, _winner{other._winner}, _state{other._state},
@@ -103,7 +110,7 @@ public:
       _moves.push_back({key, val->copy()});
   }
 
-  Game<T> &operator=(const Game<T> &other)
+  Game &operator=(const Game &other)
   {
     if (this != &other)
     {
@@ -129,12 +136,20 @@ public:
     return *this;
   }
 
-  Game(Game &&other)
-      : _turning_player{other._turning_player}, _winner{other._winner}, _state{other._state}
+  //steals the players, the board and the moves, no allocation
+  Game(Game &&other) noexcept
+      : _turning_player{other._turning_player}, _winner{other._winner}, _state{other._state},
+        _players{other._players}, _board{other._board}, _moves{std::move(other._moves)}
   {
-    *this = std::move(other);
+    // Release the data pointers from the source object so that
+    // the destructor does not free the memory multiple times.
+    other._turning_player = other._winner = -1;
+    other._state = game::Enum::NOTOVER;
+    other._players = nullptr;
+    other._board = nullptr;
+    other._moves.clear();
   }
-  Game<T> &operator=(Game<T> &&other)
+  Game &operator=(Game &&other) noexcept
   {
     if (this != &other)
     {
@@ -150,11 +165,9 @@ public:
       _turning_player = other._turning_player;
       _winner = other._winner;
       _state = other._state;
-      _players = other._players->move(); //shallow copy
-      _board = other._board->move();     //shallow copy
-
-      for (const auto &[key, val] : other._moves)
-        _moves.push_back({key, val}); //shallow copy
+      _players = other._players; //stolen
+      _board = other._board;     //stolen
+      _moves = std::move(other._moves);
 
       // Release the data pointer from the source object so that
       // the destructor does not free the memory multiple times.
@@ -248,13 +261,54 @@ public:
  */
   virtual size_t MakeMove()
   {
+    _ISSTAT_ stats::Count(stats::Enum::MAKE_MOVE);
+
     if (!(_state == game::Enum::NOTOVER))
       return 0;
 
+    std::uint64_t start = 0;
+    _ISSTAT_ start = stats::Now();
+
     Move<T> *move = _players->at(_turning_player)->SuggestMove(*this);
 
+    _ISSTAT_ stats::Latency(size_t(_turning_player), stats::Now() - start);
+
+    return Play(move);
+  }
+
+  /**
+   * @brief suggest move of the turning player on another thread, see Player::SuggestMoveAsync
+   * @code .cpp
+   * auto future = game.SuggestMoveAsync(SearchOptions::Within(50));
+   * //...drive other games...
+   * if (future.IsReady())
+   *   game.Play(future.Get());
+   * @endcode
+   */
+  inline MoveFuture<T> SuggestMoveAsync(const SearchOptions &options = {}) const
+  {
+    return _players->at(_turning_player)->SuggestMoveAsync(*this, options);
+  }
+
+  /**
+ * @brief makes a move of the turning player computed elsewhere and changes the `turning_player`
+ * @param move [ownership] deleted here, can be nullptr
+ * @return 0==>INVALID | 1==>VALID | 2==>WINNING
+ */
+  virtual size_t Play(Move<T> *move)
+  {
+    if (!move)
+      return 0;
+    if (!(_state == game::Enum::NOTOVER))
+    {
+      deleteptr(move);
+      return 0;
+    }
     if (!IsValid(*move))
+    {
+      deleteptr(move);
       return 0;
+    }
     else if (IsWinning(*move))
     {
       _state = game::Enum::OVER;
@@ -263,6 +317,14 @@ public:
 
     int ret = _state == game::Enum::OVER ? int(Apply(*move)) * 2 : Apply(*move);
     deleteptr(move);
+
+    if (_state == game::Enum::NOTOVER)
+    {
+      if (IsNoMoreMoves())
+        _state = game::Enum::DRAW;
+      else
+        _turning_player = NextPlayer();
+    }
     return ret;
   }
 
@@ -270,10 +332,10 @@ public:
 
   {
     for (const auto &player : _players->data())
-      if (IsWinningState(player->id()))
+      if (IsWinningState(player->seat()))
       {
         _state = game::Enum::OVER;
-        _winner = player->id();
+        _winner = player->seat();
         return true;
       }
     return false;
@@ -284,7 +346,10 @@ public:
     if (IsWinningStateRecheck())
       return false;
     else if (IsNoMoreMoves())
+    {
+      _state = game::Enum::DRAW;
       return true;
+    }
 
     _state = game::Enum::NOTOVER;
     return false;
@@ -349,7 +414,7 @@ protected:
   int_t _winner{-1};                                      //winner id
   game::Enum _state{game::Enum::NOTOVER};                 //game state |OVER, NOTOVER, WINNING
   Players<T> *_players{nullptr};                          //players list
-  PBoard<T> *_board{nullptr};                             //game pieces board
+  B *_board{nullptr};                                     //game pieces board
   std::vector<std::pair<size_t, const Move<T> *>> _moves; //in order game moves with player id
 };
 
@@ -0,0 +1,220 @@
+/**
+ * @file bgasync.h
+ * @brief Futures, cancellation and deadlines for moves computed off the caller's thread
+ * @date 2026-10-19
+ */
+
+#ifndef BG_ASYNC_H_
+#define BG_ASYNC_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "bgtypes.h"
+#include "bgmove.h"
+#include "bgpool.h"
+#include "bgstats.h"
+
+BG_BEGIN
+
+/**
+ * @brief shared flag, every copy cancels the same search
+ */
+class CancelToken
+{
+public:
+  CancelToken() : _flag{std::make_shared<std::atomic<bool>>(false)} {}
+
+  inline void Cancel() noexcept { _flag->store(true, std::memory_order_relaxed); }
+  inline bool IsCancelled() const noexcept { return _flag->load(std::memory_order_relaxed); }
+
+private:
+  std::shared_ptr<std::atomic<bool>> _flag;
+};
+
+/**
+ * @brief limits of one asynchronous move
+ */
+struct SearchOptions
+{
+  CancelToken token{};
+  std::uint64_t deadline{0};                     //stats::Now() time to stop at, 0 for none
+  priority::Enum priority{priority::Enum::HIGH}; //on the pool
+  ThreadPool *pool{nullptr};                     //nullptr for ThreadPool::Shared()
+
+  //options stopping `ms` milliseconds from now
+  static SearchOptions Within(std::uint64_t ms)
+  {
+    SearchOptions o;
+    o.deadline = stats::Now() + ms * 1000000;
+    return o;
+  }
+};
+
+/**
+ * @brief state shared by a search and its MoveFuture
+ * @details the searching player polls Stopped() and reports finished iterations with Publish(),
+ * the owner of the future reads them with Partial() before the final move is ready
+ * @tparam T
+ */
+template <class T>
+class MoveSearch
+{
+public:
+  explicit MoveSearch(const SearchOptions &o = {}) : _options{o} {}
+
+  MoveSearch(const MoveSearch &) = delete;
+  MoveSearch &operator=(const MoveSearch &) = delete;
+
+  virtual ~MoveSearch()
+  {
+    delete _result;
+    delete _partial;
+  }
+
+  //---------------------FOR THE SEARCH---------------------
+
+  //true once cancelled or past the deadline, the search should return its best so far
+  inline bool Stopped() const noexcept
+  {
+    return _options.token.IsCancelled() || (_options.deadline && stats::Now() >= _options.deadline);
+  }
+
+  /**
+   * @brief best move of a finished iteration
+   * @param best [deep copy]
+   * @param depth how deep it was searched
+   */
+  void Publish(const Move<T> &best, int depth)
+  {
+    Move<T> *copy = best.copy();
+    std::lock_guard<std::mutex> lock{_mutex};
+    delete _partial;
+    _partial = copy;
+    _depth = depth;
+  }
+
+  /**
+   * @brief hands over the final move, wakes Wait()
+   * @param move [ownership] can be nullptr
+   */
+  void Finish(Move<T> *move)
+  {
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _result = move;
+      _done.store(true, std::memory_order_release);
+    }
+    _cv.notify_all();
+  }
+
+  //---------------------FOR THE OWNER----------------------
+
+  inline bool IsReady() const noexcept { return _done.load(std::memory_order_acquire); }
+  inline void Cancel() noexcept { _options.token.Cancel(); }
+  inline const auto &options() const noexcept { return _options; }
+
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock{_mutex};
+    _cv.wait(lock, [this] { return IsReady(); });
+  }
+
+  //true if ready within `ns`
+  bool WaitFor(std::uint64_t ns)
+  {
+    std::unique_lock<std::mutex> lock{_mutex};
+    return _cv.wait_for(lock, std::chrono::nanoseconds(ns), [this] { return IsReady(); });
+  }
+
+  /**
+   * @brief final move, blocks until ready
+   * @return Move<T>* [ownership] nullptr if the player had none or it was taken already
+   */
+  Move<T> *Get()
+  {
+    Wait();
+    std::lock_guard<std::mutex> lock{_mutex};
+    Move<T> *move = _result;
+    _result = nullptr;
+    return move;
+  }
+
+  /**
+   * @brief best move published so far
+   * @param depth [out] its depth, 0 if none
+   * @return Move<T>* [deep copy] | nullptr
+   */
+  Move<T> *Partial(int *depth = nullptr) const
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (depth)
+      *depth = _depth;
+    return _partial ? _partial->copy() : nullptr;
+  }
+
+private:
+  SearchOptions _options;
+  mutable std::mutex _mutex;
+  std::condition_variable _cv;
+  std::atomic<bool> _done{false};
+  Move<T> *_result{nullptr};  //final move until Get()
+  Move<T> *_partial{nullptr}; //last published move
+  int _depth{0};              //depth of _partial
+};
+
+/**
+ * @brief handle to a move being computed, see Player::SuggestMoveAsync
+ * @code .cpp
+ * auto future = player.SuggestMoveAsync(game, SearchOptions::Within(100));
+ * while (!future.IsReady())
+ *   show(future.Partial());
+ * Move<T> *move = future.Get();
+ * @endcode
+ * @tparam T
+ */
+template <class T>
+class MoveFuture
+{
+public:
+  MoveFuture() = default;
+  explicit MoveFuture(std::shared_ptr<MoveSearch<T>> search) : _search{std::move(search)} {}
+
+  /**
+   * @brief future that is ready already, no thread involved
+   * @param move [ownership]
+   */
+  static MoveFuture Ready(Move<T> *move)
+  {
+    auto search = std::make_shared<MoveSearch<T>>();
+    search->Finish(move);
+    return MoveFuture{std::move(search)};
+  }
+
+  inline bool IsValid() const noexcept { return _search != nullptr; }
+  inline bool IsReady() const noexcept { return !_search || _search->IsReady(); }
+  inline void Cancel() noexcept
+  {
+    if (_search)
+      _search->Cancel();
+  }
+  inline void Wait()
+  {
+    if (_search)
+      _search->Wait();
+  }
+  inline bool WaitFor(std::uint64_t ns) { return !_search || _search->WaitFor(ns); }
+  inline Move<T> *Get() { return _search ? _search->Get() : nullptr; }
+  inline Move<T> *Partial(int *depth = nullptr) const { return _search ? _search->Partial(depth) : nullptr; }
+
+private:
+  std::shared_ptr<MoveSearch<T>> _search;
+};
+
+BG_END
+
+#endif //BG_ASYNC_H_
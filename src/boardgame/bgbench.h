@@ -0,0 +1,218 @@
+/**
+ * @file bgbench.h
+ * @brief Micro benchmarks of single operations, time and heap allocations per call, as JSON
+ * @date 2026-10-19
+ */
+
+#ifndef BG_BENCH_H_
+#define BG_BENCH_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bglog.h"
+#include "bgstats.h"
+#include "bgtypes.h"
+
+//the replacements stay out of line, inlined at a delete expression they show gcc a free() of
+//memory from operator new, which it reports as -Wmismatched-new-delete
+#if defined(_MSC_VER)
+#define BG_BENCH_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__) || defined(__clang__)
+#define BG_BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BG_BENCH_NOINLINE
+#endif
+
+/**
+ * @brief replaces the global operator new and delete with ones counting allocations per thread,
+ * expand once at namespace scope in one translation unit of the program
+ * @details without it bench::Result::allocs is -1, the plain, sized and align_val_t forms of new
+ * and delete are replaced, the nothrow forms call them, all on std::malloc and std::free, so no
+ * pointer crosses two heaps, an over-aligned block keeps what malloc gave just below it
+ */
+#define BG_BENCH_ALLOCATOR                                                                                               \
+  BG_BENCH_NOINLINE void *operator new(std::size_t n)                                                                    \
+  {                                                                                                                      \
+    ++::bg::bench::ThreadAllocations();                                                                                  \
+    if (void *p = std::malloc(n ? n : 1))                                                                                \
+      return p;                                                                                                          \
+    throw std::bad_alloc{};                                                                                              \
+  }                                                                                                                      \
+  BG_BENCH_NOINLINE void *operator new(std::size_t n, std::align_val_t a)                                                \
+  {                                                                                                                      \
+    ++::bg::bench::ThreadAllocations();                                                                                  \
+    const std::size_t align = std::max(std::size_t(a), sizeof(void *));                                                  \
+    if (void *raw = std::malloc(n + align + sizeof(void *)))                                                             \
+    {                                                                                                                    \
+      void **p = reinterpret_cast<void **>((std::uintptr_t(raw) + sizeof(void *) + align - 1) & ~(align - 1));           \
+      p[-1] = raw;                                                                                                       \
+      return p;                                                                                                          \
+    }                                                                                                                    \
+    throw std::bad_alloc{};                                                                                              \
+  }                                                                                                                      \
+  BG_BENCH_NOINLINE void *operator new[](std::size_t n) { return operator new(n); }                                      \
+  BG_BENCH_NOINLINE void *operator new[](std::size_t n, std::align_val_t a) { return operator new(n, a); }               \
+  BG_BENCH_NOINLINE void operator delete(void *p) noexcept { std::free(p); }                                             \
+  BG_BENCH_NOINLINE void operator delete[](void *p) noexcept { std::free(p); }                                           \
+  BG_BENCH_NOINLINE void operator delete(void *p, std::size_t) noexcept { std::free(p); }                                \
+  BG_BENCH_NOINLINE void operator delete[](void *p, std::size_t) noexcept { std::free(p); }                              \
+  BG_BENCH_NOINLINE void operator delete(void *p, std::align_val_t) noexcept                                             \
+  {                                                                                                                      \
+    if (p)                                                                                                               \
+      std::free(static_cast<void **>(p)[-1]);                                                                            \
+  }                                                                                                                      \
+  BG_BENCH_NOINLINE void operator delete[](void *p, std::align_val_t a) noexcept { operator delete(p, a); }              \
+  BG_BENCH_NOINLINE void operator delete(void *p, std::size_t, std::align_val_t a) noexcept { operator delete(p, a); }   \
+  BG_BENCH_NOINLINE void operator delete[](void *p, std::size_t, std::align_val_t a) noexcept { operator delete(p, a); } \
+  static const bool bg_bench_allocator_installed = (::bg::bench::Counting() = true)
+
+BG_BEGIN
+
+/**
+ * @brief usage
+ * @code .cpp
+ * BG_BENCH_ALLOCATOR; //once, at namespace scope
+ *
+ * std::vector<bench::Result> results;
+ * Board<Piece<char>> board{6, 7};
+ * results.push_back(bench::Collect("Board::copy", [&] { return board.copy(); }, [](auto *b) { delete b; }));
+ * results.push_back(bench::Run("Board::at", [&] { bench::Keep(board.at(3, 4)); }));
+ * std::cout << bench::Json(results);
+ * @endcode
+ */
+namespace bench
+{
+  //operator new calls of the calling thread, only counted with BG_BENCH_ALLOCATOR
+  inline std::uint64_t &ThreadAllocations() noexcept
+  {
+    thread_local std::uint64_t n = 0;
+    return n;
+  }
+
+  //true once BG_BENCH_ALLOCATOR is installed
+  inline bool &Counting() noexcept
+  {
+    static bool counting = false;
+    return counting;
+  }
+
+  //keeps the optimizer from dropping a result nobody reads
+  template <class T>
+  inline void Keep(const T &value) noexcept
+  {
+    [[maybe_unused]] static const void *volatile sink;
+    sink = &value;
+  }
+
+  struct Options
+  {
+    std::uint64_t min_ns{20000000}; //time a repetition must take, iterations double until it does
+    int repetitions{5};             //the median is reported
+  };
+
+  struct Result
+  {
+    std::string name;
+    std::uint64_t iterations{0}; //per repetition
+    double ns{0};                //median of the repetitions, per operation
+    double min_ns{0};            //fastest repetition, per operation
+    double allocs{-1};           //heap allocations per operation, cleanup excluded, -1 if not counted
+  };
+
+  /**
+   * @brief repeats `pass` until one takes o.min_ns, then reports the median of o.repetitions
+   * @param pass (iterations, allocations [out]) -> nanoseconds taken
+   */
+  template <class Pass>
+  Result Measure(std::string name, Pass &&pass, const Options &o = {})
+  {
+    Result r;
+    r.name = std::move(name);
+    r.iterations = 1;
+    std::uint64_t allocs = 0;
+    while (pass(r.iterations, allocs) < o.min_ns && r.iterations < (std::uint64_t{1} << 30))
+      r.iterations *= 2;
+
+    std::vector<double> per_op;
+    for (int i = 0; i < std::max(1, o.repetitions); ++i)
+      per_op.push_back(double(pass(r.iterations, allocs)) / double(r.iterations));
+    std::sort(per_op.begin(), per_op.end());
+    r.ns = per_op[per_op.size() / 2];
+    r.min_ns = per_op.front();
+    if (Counting())
+      r.allocs = double(allocs) / double(r.iterations);
+    return r;
+  }
+
+  /**
+   * @brief times `op`, the cost of `cleanup` on its results is neither timed nor counted
+   * @param op callable returning what `cleanup` takes, e.g. a pointer it allocated
+   * @note results are kept until a repetition ends, for ops that allocate
+   */
+  template <class Op, class Cleanup>
+  Result Collect(std::string name, Op &&op, Cleanup &&cleanup, const Options &o = {})
+  {
+    std::vector<decltype(op())> values;
+    return Measure(
+        std::move(name), [&](std::uint64_t iterations, std::uint64_t &allocs) {
+          values.clear();
+          values.reserve(std::size_t(iterations));
+          const std::uint64_t before = ThreadAllocations(), start = stats::Now();
+          for (std::uint64_t i = 0; i < iterations; ++i)
+            values.push_back(op());
+          const std::uint64_t ns = stats::Now() - start;
+          allocs = ThreadAllocations() - before;
+          for (auto &v : values)
+            cleanup(v);
+          return ns;
+        },
+        o);
+  }
+
+  //times `op`, whose result if any is dropped, Keep() what must not be optimized away
+  template <class Op>
+  Result Run(std::string name, Op &&op, const Options &o = {})
+  {
+    return Measure(
+        std::move(name), [&](std::uint64_t iterations, std::uint64_t &allocs) {
+          const std::uint64_t before = ThreadAllocations(), start = stats::Now();
+          for (std::uint64_t i = 0; i < iterations; ++i)
+            op();
+          const std::uint64_t ns = stats::Now() - start;
+          allocs = ThreadAllocations() - before;
+          return ns;
+        },
+        o);
+  }
+
+  /**
+   * @brief results as one JSON object, an array of {name, iterations, ns, min_ns, allocs}
+   * @param label e.g. the commit being measured, left out if empty
+   */
+  inline std::string Json(const std::vector<Result> &results, const std::string &label = "")
+  {
+    std::ostringstream out;
+    out << '{';
+    if (!label.empty())
+      out << "\"label\":\"" << label << "\",";
+    out << "\"allocs_counted\":" << (Counting() ? "true" : "false") << ",\"results\":[";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+      const Result &r = results[i];
+      out << (i ? "," : "") << "\n{\"name\":\"" << r.name << "\",\"iterations\":" << r.iterations
+          << ",\"ns\":" << r.ns << ",\"min_ns\":" << r.min_ns << ",\"allocs\":" << r.allocs << '}';
+    }
+    out << "]}\n";
+    return out.str();
+  }
+} //namespace bench
+
+BG_END
+
+#endif //BG_BENCH_H_
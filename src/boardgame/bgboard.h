@@ -16,6 +16,7 @@
 #include <utility>
 
 #include "bgtypes.h"
+#include "bgstats.h"
 
 BG_BEGIN
 
@@ -95,27 +96,27 @@ public:
   }
 
   /**
-  * @brief Move to a new Board object
+  * @brief Move to a new Board object, steals the rows, no allocation
   */
-  Board(Board<T> &&other) noexcept : _rows{other._rows}, _cols{other._cols} { *this = std::move(other); }
-  Board<T> &operator=(Board<T> &&other)
+  Board(Board<T> &&other) noexcept : _rows{other._rows}, _cols{other._cols}, _board{std::move(other._board)}
+  {
+    // Leave the source object empty so its destructor frees nothing.
+    other._board.clear();
+    other._rows = other._cols = 0;
+  }
+  Board<T> &operator=(Board<T> &&other) noexcept
   {
     if (this != &other)
     {
       // Free the existing resource.
       clear();
 
-      // Copy the data pointer from the source object.
+      // Steal the rows from the source object.
       _rows = other._rows;
       _cols = other._cols;
+      _board = std::move(other._board);
 
-      _board.resize(_rows);
-      for (auto r = 0; r < _rows; ++r)
-        for (auto c = 0; c < _cols; ++c)
-          _board.at(r).push_back(other._board.at(r).at(c)); //shallow copyinh
-
-      // Release the data pointer from the source object so that
-      // the destructor does not free the memory multiple times.
+      // Leave the source object empty so its destructor frees nothing.
       other._board.clear();
       other._rows = other._cols = 0;
     }
@@ -238,6 +239,7 @@ public:
   inline void insert(size_t row, size_t col, const T &val)
   {
     erase(row, col);
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
     if(&val)
     _board.at(row).at(col) = new T{val};
   }
@@ -252,6 +254,7 @@ public:
   inline void insert(size_t row, size_t col, T &&val)
   {
     erase(row, col);
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
     _board.at(row).at(col) = new T{std::forward<T>(val)};
   }
 
@@ -361,8 +364,16 @@ public:
 
   //--------------------VIRTUAL--------------------------
 
-  virtual Board<T> *copy() const { return new Board<T>{*this}; }
-  virtual Board<T> *move() { return new Board<T>{std::forward<Board<T>>(*this)}; }
+  virtual Board<T> *copy() const
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new Board<T>{*this};
+  }
+  virtual Board<T> *move()
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new Board<T>{std::forward<Board<T>>(*this)};
+  }
 
 protected:
   size_t _rows{0};  //rows size
@@ -0,0 +1,119 @@
+/**
+ * @file bgcpu.h
+ * @brief Runtime detection of the SIMD instruction sets used by the kernels
+ * @date 2026-10-19
+ */
+
+#ifndef BG_CPU_H_
+#define BG_CPU_H_
+
+#include <cstdlib>
+#include <cstring>
+
+#include "bgmacros.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BG_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define BG_X86 0
+#endif
+
+//functions using a wider instruction set than the translation unit is compiled for
+#if BG_X86 && (defined(__GNUC__) || defined(__clang__))
+#define BG_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define BG_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BG_TARGET_SSE41
+#define BG_TARGET_AVX2
+#endif
+
+BG_BEGIN
+
+namespace simd
+{
+  enum class Enum
+  {
+    SCALAR, //portable fallback
+    SSE41,  //2 x 64bit lanes
+    AVX2    //4 x 64bit lanes
+  };
+
+  inline const char *ToString(Enum value) noexcept
+  {
+    switch (value)
+    {
+    case Enum::SCALAR:
+      return "scalar";
+    case Enum::SSE41:
+      return "sse4.1";
+    case Enum::AVX2:
+      return "avx2";
+    }
+    return "unknown";
+  }
+
+  /**
+   * @brief asks the cpu (cpuid) which instruction sets it supports
+   * @return widest supported Enum
+   */
+  inline Enum Detect() noexcept
+  {
+#if BG_X86 && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return Enum::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+      return Enum::SSE41;
+#elif BG_X86 && defined(_MSC_VER)
+    int info[4]{};
+    __cpuid(info, 0);
+    const int ids = info[0];
+
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    if (ids >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) //os saves ymm registers
+    {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    if (avx2)
+      return Enum::AVX2;
+    if (sse41)
+      return Enum::SSE41;
+#endif
+    return Enum::SCALAR;
+  }
+
+  /**
+   * @brief instruction set the kernels should use, detected once per process
+   * @note BG_SIMD=scalar|sse4.1|avx2 in the environment can only lower the choice
+   * @return Enum
+   */
+  inline Enum Best() noexcept
+  {
+    static const Enum best = []() {
+      Enum found = Detect();
+      if (const char *env = std::getenv("BG_SIMD"))
+      {
+        if (!std::strcmp(env, "scalar"))
+          found = Enum::SCALAR;
+        else if (!std::strcmp(env, "sse4.1") && found == Enum::AVX2)
+          found = Enum::SSE41;
+      }
+      return found;
+    }();
+    return best;
+  }
+} //namespace simd
+
+BG_END
+
+#endif //BG_CPU_H_
@@ -0,0 +1,499 @@
+/**
+ * @file bglog.h
+ * @brief Levelled logger, formats lazily on a background thread fed by a ring buffer
+ * @date 2026-10-19
+ */
+
+#ifndef BG_LOG_H_
+#define BG_LOG_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "bgmacros.h"
+
+//------------COMPILE TIME LEVEL------------
+
+//0 TRACE | 1 DEBUG | 2 INFO | 3 WARN | 4 ERROR | 5 OFF, calls below it are not compiled
+#ifndef BG_LOG_LEVEL
+#if BGDEBUG
+#define BG_LOG_LEVEL 1
+#else
+#define BG_LOG_LEVEL 2
+#endif
+#endif
+
+/**
+ * @brief usage, arguments replace the `{}` of the format in order
+ * @code .cpp
+ * BGLOG_DEBUG("Players::at", "_min={}|_max={}", _min, _max);
+ * @endcode
+ * @note the format must be a string literal, it is kept as a pointer until the record is written
+ */
+#define BGLOG(level, where, ...)                       \
+  do                                                   \
+  {                                                    \
+    if constexpr (int(level) >= BG_LOG_LEVEL)          \
+      ::bg::logging::Write(level, where, __VA_ARGS__); \
+  } while (0)
+
+#define BGLOG_TRACE(where, ...) BGLOG(::bg::logging::Enum::TRACE, where, __VA_ARGS__)
+#define BGLOG_DEBUG(where, ...) BGLOG(::bg::logging::Enum::DEBUG, where, __VA_ARGS__)
+#define BGLOG_INFO(where, ...) BGLOG(::bg::logging::Enum::INFO, where, __VA_ARGS__)
+#define BGLOG_WARN(where, ...) BGLOG(::bg::logging::Enum::WARN, where, __VA_ARGS__)
+#define BGLOG_ERROR(where, ...) BGLOG(::bg::logging::Enum::ERROR, where, __VA_ARGS__)
+
+BG_BEGIN
+
+namespace logging
+{
+  enum class Enum
+  {
+    TRACE,
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR,
+    OFF
+  };
+
+  inline const char *ToString(Enum value) noexcept
+  {
+    switch (value)
+    {
+    case Enum::TRACE:
+      return "TRACE";
+    case Enum::DEBUG:
+      return "DEBUG";
+    case Enum::INFO:
+      return "INFO";
+    case Enum::WARN:
+      return "WARN";
+    case Enum::ERROR:
+      return "ERROR";
+    case Enum::OFF:
+      return "OFF";
+    }
+    return "?";
+  }
+
+  /**
+   * @brief one unformatted argument, strings are copied into the text of their record since the caller's may be gone
+   */
+  struct Arg
+  {
+    enum class Type : char
+    {
+      INT,
+      UINT,
+      DEC,
+      CHAR,
+      PTR,
+      STR
+    };
+
+    struct Text
+    {
+      std::uint16_t at;  //offset in the record text
+      std::uint16_t len; //bytes kept, "..." included if cut
+    };
+
+    Type type{Type::INT};
+    union
+    {
+      long long i;
+      unsigned long long u;
+      double d;
+      const void *p;
+      Text s;
+    };
+
+    Arg() : i{0} {}
+
+    //strings are not handled here, Record::Add copies them
+    template <class V>
+    static Arg Of(const V &v) noexcept
+    {
+      Arg a;
+      if constexpr (std::is_same_v<V, char>)
+        a.type = Type::CHAR, a.i = v;
+      else if constexpr (std::is_same_v<V, bool> || (std::is_integral_v<V> && std::is_signed_v<V>) || std::is_enum_v<V>)
+        a.type = Type::INT, a.i = (long long)(v);
+      else if constexpr (std::is_integral_v<V>)
+        a.type = Type::UINT, a.u = (unsigned long long)(v);
+      else if constexpr (std::is_floating_point_v<V>)
+        a.type = Type::DEC, a.d = double(v);
+      else
+        a.type = Type::PTR, a.p = static_cast<const void *>(v);
+      return a;
+    }
+
+    /**
+     * @brief appends the text of this argument
+     * @param text the text of the record holding it
+     */
+    inline void Print(std::string &out, const char *text) const
+    {
+      char buf[32];
+      switch (type)
+      {
+      case Type::INT:
+        std::snprintf(buf, sizeof(buf), "%lld", i);
+        break;
+      case Type::UINT:
+        std::snprintf(buf, sizeof(buf), "%llu", u);
+        break;
+      case Type::DEC:
+        std::snprintf(buf, sizeof(buf), "%g", d);
+        break;
+      case Type::CHAR:
+        buf[0] = char(i), buf[1] = '\0';
+        break;
+      case Type::PTR:
+        std::snprintf(buf, sizeof(buf), "%p", p);
+        break;
+      case Type::STR:
+        out.append(text + s.at, s.len);
+        return;
+      }
+      out += buf;
+    }
+  };
+
+  constexpr int kMaxArgs = 6;
+  constexpr std::size_t kTextBytes = 256; //shared by the string arguments of a record
+
+  /**
+   * @brief what a producer hands over, formatting happens on the writer thread
+   */
+  struct Record
+  {
+    Enum level{Enum::INFO};
+    std::uint64_t ns{0}; //since the logger started
+    const char *where{""};
+    const char *format{""};
+    int nargs{0};
+    Arg args[kMaxArgs];
+    std::uint16_t used{0}; //bytes of text taken
+    char text[kTextBytes];
+
+    //captures the next argument, a string that does not fit the text left ends with "..."
+    template <class V>
+    inline void Add(const V &v) noexcept
+    {
+      if constexpr (std::is_same_v<V, std::string>)
+        _Copy(v.data(), v.size());
+      else if constexpr (std::is_convertible_v<V, const char *>)
+      {
+        const char *str = v;
+        if (!str)
+          str = "(null)";
+        _Copy(str, std::strlen(str));
+      }
+      else
+        args[nargs++] = Arg::Of(v);
+    }
+
+    inline void Format(std::string &out) const
+    {
+      char head[64];
+      std::snprintf(head, sizeof(head), "[%10.6f] %-5s ", double(ns) / 1e9, ToString(level));
+      out += head;
+      out += where;
+      out += " --> ";
+
+      int next = 0;
+      for (const char *f = format; *f; ++f)
+        if (f[0] == '{' && f[1] == '}' && next < nargs)
+        {
+          args[next++].Print(out, text);
+          ++f;
+        }
+        else
+          out += *f;
+      out += '\n';
+    }
+
+  private:
+    inline void _Copy(const char *str, std::size_t len) noexcept
+    {
+      static constexpr char kCut[] = "...";
+      constexpr std::size_t cut = sizeof(kCut) - 1;
+
+      const std::size_t left = kTextBytes - used;
+      std::size_t keep = len;
+      if (len > left)
+        keep = left > cut ? left - cut : 0;
+      std::memcpy(text + used, str, keep);
+      if (keep < len)
+      {
+        const std::size_t mark = std::min(cut, left - keep);
+        std::memcpy(text + used + keep, kCut, mark);
+        keep += mark;
+      }
+
+      Arg &a = args[nargs++];
+      a.type = Arg::Type::STR;
+      a.s = {used, std::uint16_t(keep)};
+      used = std::uint16_t(used + keep);
+    }
+  };
+
+  /**
+   * @brief bounded multi producer queue (Vyukov), a full buffer drops records instead of blocking
+   */
+  class Ring
+  {
+  public:
+    explicit Ring(std::size_t capacity)
+    {
+      std::size_t cap = 1;
+      while (cap < capacity)
+        cap <<= 1;
+      _mask = cap - 1;
+      _cells.reset(new Cell[cap]);
+      for (std::size_t i = 0; i < cap; ++i)
+        _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool Push(const Record &r) noexcept
+    {
+      std::size_t pos = _tail.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        Cell &cell = _cells[pos & _mask];
+        const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+        const auto diff = std::intptr_t(seq) - std::intptr_t(pos);
+        if (diff == 0)
+        {
+          if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          {
+            cell.record = r;
+            cell.seq.store(pos + 1, std::memory_order_release);
+            return true;
+          }
+        }
+        else if (diff < 0)
+          return false; //full
+        else
+          pos = _tail.load(std::memory_order_relaxed);
+      }
+    }
+
+    //single consumer
+    bool Pop(Record &r) noexcept
+    {
+      Cell &cell = _cells[_head & _mask];
+      if (cell.seq.load(std::memory_order_acquire) != _head + 1)
+        return false;
+      r = cell.record;
+      cell.seq.store(_head + _mask + 1, std::memory_order_release);
+      ++_head;
+      return true;
+    }
+
+  private:
+    struct Cell
+    {
+      std::atomic<std::size_t> seq{0};
+      Record record;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask{0};
+    alignas(64) std::atomic<std::size_t> _tail{0};
+    alignas(64) std::size_t _head{0};
+  };
+
+  /**
+   * @brief process wide logger, the writer thread starts with the first record
+   */
+  class Logger
+  {
+  public:
+    static Logger &Get()
+    {
+      static Logger logger;
+      return logger;
+    }
+
+    ~Logger()
+    {
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _stop = true;
+      }
+      _wake.notify_one();
+      if (_writer.joinable())
+        _writer.join();
+    }
+
+    inline Enum level() const noexcept { return _level.load(std::memory_order_relaxed); }
+    inline void set_level(Enum level) noexcept { _level.store(level, std::memory_order_relaxed); }
+    //records lost because the ring was full
+    inline auto dropped() const noexcept { return _dropped.load(std::memory_order_relaxed); }
+
+    //where records are written, stdout by default
+    inline void set_sink(std::FILE *sink)
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _sink = sink;
+    }
+
+    //never throws, a record that cannot be queued, or whose writer thread cannot start, is dropped
+    void Push(const Record &r) noexcept
+    {
+      if (!_Start() || !_ring.Push(r))
+      {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      if (_sleeping.load(std::memory_order_relaxed))
+        _wake.notify_one();
+    }
+
+    //blocks until every record pushed so far is written
+    void Flush()
+    {
+      if (!_started.load(std::memory_order_acquire))
+        return;
+      std::unique_lock<std::mutex> lock{_mutex};
+      const auto target = ++_flush_requests;
+      _wake.notify_one();
+      _flushed.wait(lock, [&] { return _flush_done >= target || _stop; });
+    }
+
+    inline std::uint64_t Now() const noexcept
+    {
+      return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count());
+    }
+
+  private:
+    Logger() : _ring{1 << 12}, _epoch{std::chrono::steady_clock::now()} {}
+
+    //false if the writer thread could not be started
+    inline bool _Start() noexcept
+    {
+      if (_started.load(std::memory_order_acquire))
+        return true;
+      try
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (!_started.load(std::memory_order_relaxed))
+        {
+          _writer = std::thread{[this] { _Run(); }};
+          _started.store(true, std::memory_order_release);
+        }
+        return true;
+      }
+      catch (...)
+      {
+        return false;
+      }
+    }
+
+    void _Run()
+    {
+      std::string line;
+      Record r;
+      for (;;)
+      {
+        bool any = false;
+        while (_ring.Pop(r))
+        {
+          line.clear();
+          r.Format(line);
+          std::lock_guard<std::mutex> lock{_mutex};
+          std::fwrite(line.data(), 1, line.size(), _sink);
+          any = true;
+        }
+
+        std::unique_lock<std::mutex> lock{_mutex};
+        if (any)
+          std::fflush(_sink);
+        if (_flush_done < _flush_requests)
+        {
+          _flush_done = _flush_requests;
+          _flushed.notify_all();
+          continue; //records pushed meanwhile are picked up by the next pass
+        }
+        if (_stop)
+        {
+          lock.unlock();
+          while (_ring.Pop(r))
+          {
+            line.clear();
+            r.Format(line);
+            std::fwrite(line.data(), 1, line.size(), _sink);
+          }
+          std::fflush(_sink);
+          _flushed.notify_all();
+          return;
+        }
+
+        _sleeping.store(true, std::memory_order_relaxed);
+        _wake.wait_for(lock, std::chrono::milliseconds(10));
+        _sleeping.store(false, std::memory_order_relaxed);
+      }
+    }
+
+  private:
+    Ring _ring;
+    const std::chrono::steady_clock::time_point _epoch;
+    std::atomic<Enum> _level{Enum::TRACE};
+    std::atomic<std::uint64_t> _dropped{0};
+    std::atomic<bool> _started{false};
+    std::atomic<bool> _sleeping{false};
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _flushed;
+    std::uint64_t _flush_requests{0};
+    std::uint64_t _flush_done{0};
+    bool _stop{false};
+    std::FILE *_sink{stdout};
+    std::thread _writer;
+  };
+
+  /**
+   * @brief queues a record, only the arguments are captured here
+   * @note called through the BGLOG macros so filtered levels cost nothing, never throws so noexcept code may log
+   */
+  template <class... Args>
+  inline void Write(Enum level, const char *where, const char *format, const Args &...args) noexcept
+  {
+    static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+
+    Logger &logger = Logger::Get();
+    if (level < logger.level())
+      return;
+
+    Record r;
+    r.level = level;
+    r.ns = logger.Now();
+    r.where = where;
+    r.format = format;
+    (r.Add(args), ...);
+    logger.Push(r);
+  }
+
+  inline void Write(Enum level, const char *where) noexcept { Write(level, where, ""); }
+
+  inline void SetLevel(Enum level) noexcept { Logger::Get().set_level(level); }
+  inline void SetSink(std::FILE *sink) { Logger::Get().set_sink(sink); }
+  inline void Flush() { Logger::Get().Flush(); }
+} //namespace logging
+
+BG_END
+
+#endif //BG_LOG_H_
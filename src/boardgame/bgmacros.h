@@ -48,6 +48,14 @@
   {
 #define _ISDBGE }
 
+//-------------STATISTICS-------------
+
+//counters and timers of bgstats.h, off unless built with -DBG_STATS=1
+#ifndef BG_STATS
+#define BG_STATS 0
+#endif
+#define _ISSTAT_ if constexpr (BG_STATS)
+
 //#if BG_DEBUG
 //constexpr auto BGDEBUG = true;
 //#else
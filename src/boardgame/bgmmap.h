@@ -0,0 +1,162 @@
+/**
+ * @file bgmmap.h
+ * @brief Read only view of a whole file, memory mapped where the OS allows it
+ * @date 2026-10-19
+ */
+
+#ifndef BG_MMAP_H_
+#define BG_MMAP_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bgtypes.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BG_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define BG_MMAP 0
+#endif
+
+BG_BEGIN
+
+/**
+ * @brief maps a file into memory, or reads it into a buffer where mmap is not available
+ * @code .cpp
+ * MappedFile f;
+ * if (f.Open("table.bin"))
+ *   use(f.data(), f.size());
+ * @endcode
+ */
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path) { Open(path); }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+  MappedFile &operator=(MappedFile &&other) noexcept
+  {
+    if (this != &other)
+    {
+      Close();
+      _data = other._data;
+      _size = other._size;
+      _mapped = other._mapped;
+      _buffer.swap(other._buffer);
+      other._data = nullptr;
+      other._size = 0;
+      other._mapped = false;
+    }
+    return *this;
+  }
+
+  virtual ~MappedFile() { Close(); }
+
+  //----------------------GETTERS-----------------------
+
+  inline const unsigned char *data() const noexcept { return _data; }
+  inline size_t size() const noexcept { return _size; }
+  inline bool IsOpen() const noexcept { return _data != nullptr || (_size == 0 && _mapped); }
+  //true if the pages come from the OS page cache rather than a private copy
+  inline bool mapped() const noexcept { return _mapped; }
+
+  //----------------------FUNCTIONS---------------------
+
+  /**
+   * @brief maps the whole file
+   * @param path
+   * @return true | false if it cannot be opened
+   */
+  bool Open(const std::string &path)
+  {
+    Close();
+#if BG_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    _size = size_t(st.st_size);
+    if (_size)
+    {
+      void *p = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED)
+      {
+        ::close(fd);
+        _size = 0;
+        return false;
+      }
+      _data = static_cast<const unsigned char *>(p);
+    }
+    ::close(fd); //the mapping keeps the file alive
+    _mapped = true;
+    return true;
+#else
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f)
+      return false;
+    std::fseek(f, 0, SEEK_END);
+    _buffer.resize(size_t(std::ftell(f)));
+    std::fseek(f, 0, SEEK_SET);
+    const bool ok = std::fread(_buffer.data(), 1, _buffer.size(), f) == _buffer.size();
+    std::fclose(f);
+    if (!ok)
+    {
+      _buffer.clear();
+      return false;
+    }
+    _data = _buffer.data();
+    _size = _buffer.size();
+    return true;
+#endif
+  }
+
+  //unmaps the file
+  void Close() noexcept
+  {
+#if BG_MMAP
+    if (_mapped && _data)
+      ::munmap(const_cast<unsigned char *>(_data), _size);
+#endif
+    _buffer.clear();
+    _data = nullptr;
+    _size = 0;
+    _mapped = false;
+  }
+
+  /**
+   * @brief hints the OS that the pages will be read at random, or in order
+   */
+  inline void Advise(bool random) const noexcept
+  {
+#if BG_MMAP
+    if (_mapped && _data)
+      ::madvise(const_cast<unsigned char *>(_data), _size, random ? MADV_RANDOM : MADV_SEQUENTIAL);
+#else
+    (void)random;
+#endif
+  }
+
+private:
+  const unsigned char *_data{nullptr};
+  size_t _size{0};
+  bool _mapped{false};
+  std::vector<unsigned char> _buffer; //file contents when mmap is not available
+};
+
+BG_END
+
+#endif //BG_MMAP_H_
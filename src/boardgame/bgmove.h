@@ -13,7 +13,9 @@
 #define BG_MOVE_H_
 
 #include "bgtypes.h"
+#include "bglog.h"
 #include "bgpiece.h"
+#include "bgstats.h"
 
 BG_BEGIN
 
@@ -54,12 +56,12 @@ public:
    */
   Move(int_t row, int_t col, const Piece<T> &piece) noexcept : _row{row}, _col{col}, _piece{piece.copy()}
   {
-    _ISDBG_ bgdebug("Move::Move(int,int,ptr)", "row=" + std::to_string(row) + "|_row=" + std::to_string(_row) + "|col=" + std::to_string(col) + "|_col=" + std::to_string(_col));
+    BGLOG_TRACE("Move::Move(int,int,ptr)", "row={}|_row={}|col={}|_col={}", row, _row, col, _col);
   }
 
   Move(int_t row, int_t col, Piece<T> &&piece) noexcept : _row{row}, _col{col}, _piece{piece.move()}
   {
-    _ISDBG_ bgdebug("Move::Move(int,int,ptr)", "row=" + std::to_string(row) + "|_row=" + std::to_string(_row) + "|col=" + std::to_string(col) + "|_col=" + std::to_string(_col));
+    BGLOG_TRACE("Move::Move(int,int,ptr)", "row={}|_row={}|col={}|_col={}", row, _row, col, _col);
   }
 
   Move(const Move<T> &other) : _row{other._row}, _col{other._col}, _piece{other._piece->copy()} {}
@@ -73,7 +75,7 @@ public:
 
       // Copy the data pointer and its length from the
       // source object.
-      _piece = new Piece<T>{other._piece};
+      _piece = other._piece->copy();
       _row = other._row;
       _col = other._col;
     }
@@ -110,7 +112,7 @@ public:
    */
   virtual ~Move()
   {
-    _ISDBG_ bgdebug("Move::~Move");
+    BGLOG_TRACE("Move::~Move", "");
 
     _row = -1;
     _col = -1;
@@ -146,8 +148,16 @@ public:
 
   //-----------------VIRTUAL--------------------
 
-  virtual Move<T> *copy() const { return new Move<T>{*this}; }
-  virtual Move<T> *move() { return new Move<T>{std::forward<Move<T>>(*this)}; }
+  virtual Move<T> *copy() const
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new Move<T>{*this};
+  }
+  virtual Move<T> *move()
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new Move<T>{std::forward<Move<T>>(*this)};
+  }
 
 protected:
   int_t _row{-1};            //row
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "bgmacros.h"
+#include "bgstats.h"
 #include "color.h"
 
 BG_BEGIN
@@ -16,12 +17,26 @@ struct Piece
 
   Piece() : val{}, color{color::Enum::WHITE} {}
   Piece(T v, color::Enum c = color::Enum::WHITE) : val{v}, color{c} {}
+  Piece(const Piece &) = default;
+  Piece(Piece &&) noexcept = default;
+  Piece &operator=(const Piece &) = default;
+  Piece &operator=(Piece &&) noexcept = default;
+  //copy() and move() hand out Piece<T>* that owners delete, a derived piece must be destroyed whole
+  virtual ~Piece() = default;
 
   T &get() noexcept { return val; }
   const T &get() const noexcept { return val; }
 
-  virtual Piece<T> *copy() const { return new Piece<T>{*this}; }
-  virtual Piece<T> *move() { return new Piece<T>{std::forward<Piece<T>>(*this)}; }
+  virtual Piece<T> *copy() const
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new Piece<T>{*this};
+  }
+  virtual Piece<T> *move()
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new Piece<T>{std::forward<Piece<T>>(*this)};
+  }
 
   int cmp(const Piece &P)
   {
@@ -15,15 +15,19 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <memory>
 
 #include "bgtypes.h"
+#include "bglog.h"
+#include "bgboard.h"
 #include "bgame.h"
 #include "bgpiece.h"
 #include "bgmove.h"
+#include "bgasync.h"
 
 BG_BEGIN
 
-template <class T>
+template <class T, class B = Board<Piece<T>>>
 class Game;
 
 //using ::bg::Game;
@@ -34,6 +38,8 @@ class Game;
  * @code .cpp
  * virtual ~Player();
  * virtual Move* SuggestMove(const Game<T> &) const = 0;
+ * virtual Move* SuggestMove(const Game<T> &, MoveSearch<T> &) const;
+ * virtual Move* Immediate(const Game<T> &) const;
  * virtual Player* copy() const = 0;
  * virtual Player* move() = 0;
  * @endcode
@@ -56,7 +62,7 @@ public:
    */
   Player(const std::string name, size_t diff_level) : _id{_next_id++}, _name{name}, _diff_level{diff_level}
   {
-    _ISDBG_ bgdebug("Player::Player(name,diff)", "_id=" + std::to_string(_id) + "|_name=" + _name + "|_diff" + std::to_string(_diff_level));
+    BGLOG_DEBUG("Player::Player(name,diff)", "_id={}|_name={}|_diff{}", _id, _name, _diff_level);
   }
 
   /**
@@ -68,7 +74,7 @@ public:
    */
   Player(const std::string name, size_t diff_level, const Piece<T> &piece) : _id{_next_id++}, _name{name}, _diff_level{diff_level}
   {
-    _ISDBG_ bgdebug("Player::Player(name,diff,Piece<T>)", "_id=" + std::to_string(_id) + "|_name=" + _name + "|_diff" + std::to_string(_diff_level) + "|piece=" + std::to_string(piece.get()));
+    BGLOG_DEBUG("Player::Player(name,diff,Piece<T>)", "_id={}|_name={}|_diff{}|piece={}", _id, _name, _diff_level, piece.get());
 
     _pieces.push_back(piece.copy());
   }
@@ -82,7 +88,7 @@ public:
    */
   Player(const std::string name, size_t diff_level, Piece<T> &&piece) : _id{_next_id++}, _name{name}, _diff_level{diff_level}
   {
-    _ISDBG_ bgdebug("Player::Player(name,diff,Piece<T>)", "_id=" + std::to_string(_id) + "|_name=" + _name + "|_diff" + std::to_string(diff_level) + "|piece=" + std::to_string(piece.get()));
+    BGLOG_DEBUG("Player::Player(name,diff,Piece<T>)", "_id={}|_name={}|_diff{}|piece={}", _id, _name, diff_level, piece.get());
 
     _pieces.push_back(piece.move());
   }
@@ -96,13 +102,13 @@ public:
    */
   Player(const std::string name, size_t diff_level, const Pieces<T> &pieces) : _id{_next_id++}, _name{name}, _diff_level{diff_level}
   {
-    _ISDBG_ bgdebug("Player::Player(name,diff,Pieces<T>)", "_id=" + std::to_string(_id) + "|_name=" + _name + "|_diff" + std::to_string(diff_level) + "|pieces=" + std::to_string(pieces.size()));
+    BGLOG_DEBUG("Player::Player(name,diff,Pieces<T>)", "_id={}|_name={}|_diff{}|pieces={}", _id, _name, diff_level, pieces.size());
 
     for (auto &piece : pieces)
       _pieces.push_back(piece->copy());
   }
 
-  Player(const Player<T> &other) : _id{other._id}, _name{other._name}, _diff_level{other._diff_level}
+  Player(const Player<T> &other) : _id{other._id}, _seat{other._seat}, _name{other._name}, _diff_level{other._diff_level}
   {
     for (const auto &p : other._pieces)
       _pieces.push_back(p->copy());
@@ -121,7 +127,8 @@ public:
 
       // Copy the data source object.
       // _id = other.id;
-      _name = other.name;
+      _seat = other._seat;
+      _name = other._name;
       _diff_level = other._diff_level;
 
       for (const auto &p : other._pieces)
@@ -130,32 +137,33 @@ public:
     return *this;
   }
 
-  Player(Player<T> &&other) : _id{other._id}, _name{other._name}, _diff_level{other._diff_level}
+  //steals the name and the pieces, no allocation
+  Player(Player<T> &&other) noexcept
+      : _id{other._id}, _seat{other._seat}, _name{std::move(other._name)}, _diff_level{other._diff_level},
+        _pieces{std::move(other._pieces)}
   {
-    *this = std::move(other);
+    // Leave the source object empty so its destructor frees nothing.
+    other._pieces.clear();
+    other._name.clear();
+    other._diff_level = 0;
   }
 
-  Player<T> &operator=(Player<T> &&other)
+  Player<T> &operator=(Player<T> &&other) noexcept
   {
     if (this != &other)
     {
       // Free the existing resource.
-      _name.clear();
-
       for (auto &p : _pieces)
         delete p;
-      _pieces.clear();
 
-      // Copy the data pointer from the source object.
+      // Steal the name and the pieces from the source object.
       //_id = other._id;
-      _name = other._name;
+      _seat = other._seat;
+      _name = std::move(other._name);
       _diff_level = other._diff_level;
+      _pieces = std::move(other._pieces);
 
-      for (auto &p : other._pieces)
-        _pieces.push_back(p->move());
-
-      // Release the data pointer from the source object so that
-      // the destructor does not free the memory multiple times.
+      // Leave the source object empty so its destructor frees nothing.
       other._pieces.clear();
       other._name.clear();
       other._diff_level = 0;
@@ -168,7 +176,7 @@ public:
    */
   virtual ~Player()
   {
-    _ISDBG_ bgdebug("Player::~Player", "_id=" + std::to_string(_id));
+    BGLOG_DEBUG("Player::~Player", "_id={}", _id);
 
     _diff_level = 0;
 
@@ -183,6 +191,8 @@ public:
 
   inline auto name() const noexcept { return _name; }
   inline auto id() const noexcept { return _id; }
+  //game local number given by Players::insert
+  inline auto seat() const noexcept { return _seat; }
   inline auto diff_level() const noexcept { return _diff_level; }
   inline const auto &pieces() const { return _pieces; }
 
@@ -190,6 +200,7 @@ public:
 
   inline void set_name(const std::string &name) { _name = name; }
   inline void set_diff_level(size_t diff_level) { _diff_level = diff_level; }
+  inline void set_seat(size_t seat) noexcept { _seat = seat; }
 
   /**
    * @brief inserting piece
@@ -198,7 +209,7 @@ public:
    */
   inline void insert(const Piece<T> &piece)
   {
-    _ISDBG_ bgdebug("Player::insert(Piece<T>)", "_id=" + std::to_string(_id));
+    BGLOG_DEBUG("Player::insert(Piece<T>)", "_id={}", _id);
 
     _pieces.push_back(piece.copy());
   }
@@ -210,7 +221,7 @@ public:
  */
   inline void insert(Piece<T> &&piece)
   {
-    _ISDBG_ bgdebug("Player::insert(Piece<T>)", "_id=" + std::to_string(_id));
+    BGLOG_DEBUG("Player::insert(Piece<T>)", "_id={}", _id);
 
     _pieces.push_back(piece.move());
   }
@@ -221,7 +232,7 @@ public:
    */
   inline void insert(const Pieces<T> &pieces)
   {
-    _ISDBG_ bgdebug("Player::insert(Pieces<T>)", "_id=" + std::to_string(_id));
+    BGLOG_DEBUG("Player::insert(Pieces<T>)", "_id={}", _id);
 
     for (auto &piece : pieces)
       _pieces.push_back(piece->copy());
@@ -236,7 +247,7 @@ public:
    */
   inline bool IsPlayerPiece(const Piece<T> &piece) const
   {
-    _ISDBG_ bgdebug("Player::IsPlayerPiece", "_id=" + std::to_string(_id));
+    BGLOG_TRACE("Player::IsPlayerPiece", "_id={}", _id);
 
     for (auto &p : _pieces)
       if (p && &piece && *p == piece)
@@ -251,7 +262,7 @@ public:
    */
   inline auto FindPiece(const Piece<T> &piece) const
   {
-    _ISDBG_ bgdebug("Player::_FinePiece", "_id=" + std::to_string(_id));
+    BGLOG_TRACE("Player::FindPiece", "_id={}", _id);
 
     auto it = std::find(_pieces.begin(), _pieces.end(), piece);
     if (it != _pieces.end())
@@ -270,8 +281,61 @@ public:
   virtual Player<T> *copy() const = 0;
   virtual Player<T> *move() = 0;
 
+  /**
+   * @brief [virtual] suggest move that can be stopped early, used by SuggestMoveAsync
+   * @details overrides poll `search.Stopped()` and `search.Publish()` their best move so far,
+   * the default ignores both
+   * @param state [only using, no delete]
+   * @param search
+   * @return Move<T>*
+   */
+  virtual Move<T> *SuggestMove(const Game<T> &state, MoveSearch<T> &search) const
+  {
+    (void)search;
+    return SuggestMove(state);
+  }
+
+  /**
+   * @brief [virtual] move known without searching (book hit, forced move)
+   * @param state [only using, no delete]
+   * @return Move<T>* | nullptr to search
+   */
+  virtual Move<T> *Immediate(const Game<T> &state) const
+  {
+    (void)state;
+    return nullptr;
+  }
+
+  //-------------------ASYNC------------------------
+
+  /**
+   * @brief suggest move on another thread
+   * @details Immediate() answers complete without a thread hop, otherwise the search runs on the
+   * thread pool with a copy of `state`, so the caller can keep using it, stopping at the options' deadline or token
+   * @param state [copied]
+   * @param options
+   * @return MoveFuture<T>
+   */
+  MoveFuture<T> SuggestMoveAsync(const Game<T> &state, const SearchOptions &options = {}) const
+  {
+    if (Move<T> *move = Immediate(state))
+      return MoveFuture<T>::Ready(move);
+
+    auto search = std::make_shared<MoveSearch<T>>(options);
+    Game<T> *snapshot = state.copy();
+    ThreadPool &pool = options.pool ? *options.pool : ThreadPool::Shared();
+    auto task = [snapshot, search, seat = _seat] {
+      Move<T> *move = snapshot->players()->at(seat)->SuggestMove(*snapshot, *search);
+      delete snapshot;
+      search->Finish(move);
+    };
+    pool.Submit(task, options.priority);
+    return MoveFuture<T>{search};
+  }
+
 protected:
   csize_t _id{_next_id++}; //unique player id
+  size_t _seat{0};         //index in the game's Players
   std::string _name;       //player name
   size_t _diff_level{0};   //difficulty level
   Pieces<T> _pieces;       //pieces of current player
@@ -12,14 +12,17 @@
 #ifndef BG_PLAYERS_H_
 #define BG_PLAYERS_H_
 
+#include <array>
+#include <memory>
 #include <vector>
 #include <unordered_map>
-#include <algorithm>
-#include <iterator>
+#include <type_traits>
 #include <utility>
 
 #include "bgtypes.h"
+#include "bglog.h"
 #include "bgplayer.h"
+#include "bgstats.h"
 
 BG_BEGIN
 
@@ -28,6 +31,8 @@ class Player;
 
 /**
  * @brief General Players class for storing list of Player
+ * @details players sit in a dense table, the index is the game local seat number
+ * given by insert() (0, 1, ...), Player::id() stays the process wide identity
  * @code .cpp
  * virtual ~Players();
  * @endcode
@@ -37,6 +42,10 @@ class Player;
 template <typename T>
 class Players
 {
+  //one byte pieces get a direct lookup table, anything else a hash map
+  static constexpr bool kByteTable = sizeof(T) == 1 && std::is_integral_v<T>;
+  using seat_table = std::conditional_t<kByteTable, std::array<int_t, 256>, std::unordered_map<T, int_t>>;
+
 public:
   //-------------------CONSTRUCTORS----------------------------------------------------------
 
@@ -45,7 +54,7 @@ public:
    */
   Players() noexcept : _min{0}, _max{0}
   {
-    _ISDBG_ bgdebug("Players::Players", "_min=" + std::to_string(_min) + "|_max" + std::to_string(_max) + "|_players=" + std::to_string(_players.size()));
+    BGLOG_DEBUG("Players::Players", "_min={}|_max{}|_players={}", _min, _max, _players.size());
   }
 
   /**
@@ -56,13 +65,16 @@ public:
    */
   Players(size_t min, size_t max) noexcept : _min{min}, _max{max}
   {
-    _ISDBG_ bgdebug("Players::Players(size_t,size_t)", "_min=" + std::to_string(_min) + "|_max" + std::to_string(_max) + "|_players=" + std::to_string(_players.size()));
+    BGLOG_DEBUG("Players::Players(size_t,size_t)", "_min={}|_max{}|_players={}", _min, _max, _players.size());
+    _players.reserve(max);
   }
 
-  Players(const Players<T> &other) : _min{other._min}, _max{other._max}
+  Players(const Players<T> &other)
+      : _min{other._min}, _max{other._max}, _seats{other._seats ? new seat_table{*other._seats} : nullptr}
   {
-    for (const auto &[key, val] : other._players)
-      _players.insert({key, val->copy()}); //copying data from pointer
+    _players.reserve(other._players.capacity());
+    for (const auto &val : other._players)
+      _players.push_back(val->copy()); //copying data from pointer
   }
 
   Players<T> &operator=(const Players<T> &other)
@@ -70,40 +82,43 @@ public:
     if (this != &other)
     {
       // Free the existing resource.
-      for (auto &[key, value] : _players)
-        delete value;
-      _players.clear();
+      _Free();
 
       // Copy the data pointer from the source object.
-      _min = other._max;
-      _min = other._max;
-      for (const auto &[key, val] : other._players)
-        _players.insert({key, val->copy()}); //copying data from pointer
+      _min = other._min;
+      _max = other._max;
+      if (other._seats)
+        _seats.reset(new seat_table{*other._seats});
+      for (const auto &val : other._players)
+        _players.push_back(val->copy()); //copying data from pointer
     }
     return *this;
   }
 
-  Players(Players<T> &&other) : _min{other._min}, _max{other._max} {  *this = std::move(other); }
+  Players(Players<T> &&other) noexcept
+      : _min{other._min}, _max{other._max}, _players{std::move(other._players)}, _seats{std::move(other._seats)}
+  {
+    // Leave the source object empty, without a seat table until a player is seated.
+    other._players.clear();
+    other._min = other._max = 0;
+  }
 
-  Players<T> &operator=(Players<T> &&other)
+  Players<T> &operator=(Players<T> &&other) noexcept
   {
     if (this != &other)
     {
       // Free the existing resource.
-      for (auto &[key, value] : _players)
-        delete value;
-      _players.clear();
+      _Free();
 
-      // Copy the data pointer from the source object.
-      _min = other._max;
-      _min = other._max;
-      for (const auto &[key, val] : other._players)
-        _players.insert({key, val->move()}); //moving data from pointer
-
-      // Release the data pointer from the source object so that
-      // the destructor does not free the memory multiple times.
-      other._players.clear();
+      // Steal the tables from the source object, the players themselves do not move.
+      _min = other._min;
+      _max = other._max;
+      _players.swap(other._players);
+      _seats.swap(other._seats);
+
+      // Leave the source object empty.
       other._min = other._max = 0;
+      other._ClearSeats();
     }
     return *this;
   }
@@ -113,13 +128,10 @@ public:
    */
   virtual ~Players()
   {
-    _ISDBG_ bgdebug("Players::~Players", "_min=" + std::to_string(_min) + "|_max" + std::to_string(_max) + "|_players=" + std::to_string(_players.size()));
+    BGLOG_DEBUG("Players::~Players", "_min={}|_max{}|_players={}", _min, _max, _players.size());
 
     _min = _max = 0;
-
-    for (auto &[key, value] : _players)
-      delete value;
-    _players.clear();
+    _Free();
   }
 
   //-----------------------GETTERS------------------------------------------------------------
@@ -134,50 +146,56 @@ public:
   /**
    * @brief direct refrence to the player object
    *
-   * @param playerid
+   * @param seat game local player number
    * @return const Player<T>&
    */
-  const auto &at(size_t playerid) const
+  const auto &at(size_t seat) const
   {
-    _ISDBG_ bgdebug("Players::at", "_min=" + std::to_string(_min) + "|_max" + std::to_string(_max) + "|_players=" + std::to_string(_players.size()));
+    BGLOG_TRACE("Players::at", "seat={}|_players={}", seat, _players.size());
 
-    return _players.at(playerid);
+    return _players.at(seat);
   }
   /**
    * @brief direct refrence to the player object
    *
-   * @param playerid
+   * @param seat game local player number
    * @return Player<T>&
    */
-  auto &at(size_t playerid)
+  auto &at(size_t seat)
   {
-    _ISDBG_ bgdebug("Players::at", "_min=" + std::to_string(_min) + "|_max" + std::to_string(_max) + "|_players=" + std::to_string(_players.size()));
+    BGLOG_TRACE("Players::at", "seat={}|_players={}", seat, _players.size());
 
-    return _players.at(playerid);
+    return _players.at(seat);
   }
 
   /**
-   * @brief direct pointer to the memory array used internally by the Players
-   *
-   * @return const std::vector<Player<T>*>&
+   * @brief seat of the player owning the piece
+   * @details pieces mapped when their player was seated are one lookup, a piece given to a
+   * seated player later through Player::insert is found by walking the players
+   * @param piece
+   * @return int_t -1 if no player owns it
    */
-  const auto &data() const
+  inline int_t SeatOf(const Piece<T> &piece) const
   {
-    std::vector<Player<T> *> vecplayers;
-    std::transform(_players.begin(), _players.end(), std::back_inserter(vecplayers), [](auto &kv) { return kv.second; });
-    return vecplayers;
+    int_t seat;
+    if (!_seats)
+      seat = -1;
+    else if constexpr (kByteTable)
+      seat = (*_seats)[static_cast<unsigned char>(piece.get())];
+    else
+    {
+      const auto it = _seats->find(piece.get());
+      seat = it == _seats->end() ? -1 : it->second;
+    }
+    return seat >= 0 ? seat : _FindSeat(piece);
   }
+
   /**
    * @brief direct pointer to the memory array used internally by the Players
    *
-   * @return std::vector<Player<T> *> &
+   * @return const std::vector<Player<T>*>& indexed by seat
    */
-  auto &data()
-  {
-    std::vector<Player<T> *> vecplayers;
-    std::transform(_players.begin(), _players.end(), std::back_inserter(vecplayers), [](auto &kv) { return kv.second; });
-    return vecplayers;
-  }
+  inline const auto &data() const noexcept { return _players; }
 
   //-----------------------SETTERS-----------------------------------------------------------
 
@@ -187,46 +205,53 @@ public:
   inline void set_min(size_t min) { _min = min; }
 
   /**
-   * @brief [deep copy] [using till lifetime]
+   * @brief [deep copy] [using till lifetime], takes the next free seat
    * @param Player Player<T>*
    * @return true | false
    */
   inline bool insert(const Player<T> &P)
   {
-    _ISDBG_ bgdebug("Players::insert", "_min=" + std::to_string(_min) + "|_max" + std::to_string(_max) + "|_players=" + std::to_string(_players.size()));
+    BGLOG_DEBUG("Players::insert", "_min={}|_max{}|_players={}", _min, _max, _players.size());
 
     if (size() < max())
     {
-      _players.insert({P.id(), P.copy()});
+      _Seat(P.copy());
       return true;
     }
     return false;
   }
 
   /**
-   * @brief [move copy] [using till lifetime]
+   * @brief [move copy] [using till lifetime], takes the next free seat
    * @param Player Player<T>*
    * @return true | false
    */
   inline bool insert(Player<T> &&P)
   {
-    _ISDBG_ bgdebug("Players::insert", "_min=" + std::to_string(_min) + "|_max" + std::to_string(_max) + "|_players=" + std::to_string(_players.size()));
+    BGLOG_DEBUG("Players::insert", "_min={}|_max{}|_players={}", _min, _max, _players.size());
 
     if (size() < max())
     {
-      _players.insert({P.id(), P.move()});
+      _Seat(P.move());
       return true;
     }
     return false;
   }
 
-  //remove player
-  inline void erase(size_t playerid)
+  //remove player, the players after it move one seat down
+  inline void erase(size_t seat)
   {
-    _ISDBG_ bgdebug("Players::insert", "playerid=" + std::to_string(playerid) + "|_min=" + std::to_string(_min) + "|_max" + std::to_string(_max) + "|_players=" + std::to_string(_players.size()));
+    BGLOG_DEBUG("Players::erase", "seat={}|_min={}|_max{}|_players={}", seat, _min, _max, _players.size());
+
+    delete _players.at(seat);
+    _players.erase(_players.begin() + seat);
 
-    delete _players.at(playerid);
-    _players.erase(playerid);
+    _ClearSeats();
+    for (size_t s = 0; s < _players.size(); ++s)
+    {
+      _players[s]->set_seat(s);
+      _MapPieces(*_players[s]);
+    }
   }
 
   //-------------------OPERATORS-----------------------------------------------------------------
@@ -234,27 +259,90 @@ public:
   /**
    * @brief direct pointer to the memory array used internally by the Players
    *
-   * @param playerid
+   * @param seat
    * @return const Player<T>*
    */
-  const auto &operator[](size_t playerid) const { return at(playerid); }
+  const auto &operator[](size_t seat) const { return at(seat); }
   /**
    * @brief direct pointer to the memory array used internally by the Players
    *
-   * @param playerid
+   * @param seat
    * @return Player<T>*
    */
-  auto &operator[](size_t playerid) { return at(playerid); }
+  auto &operator[](size_t seat) { return at(seat); }
 
   //--------------------VIRTUAL--------------------------------
 
-  virtual Players<T> *copy() const { return new Players<T>{*this}; }
-  virtual Players<T> *move() { return new Players<T>{std::forward<Players<T>>(*this)}; }
+  virtual Players<T> *copy() const
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new Players<T>{*this};
+  }
+  virtual Players<T> *move()
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new Players<T>{std::forward<Players<T>>(*this)};
+  }
 
 protected:
-  size_t _min{0};                                   //minimum number of players in game
-  size_t _max{0};                                   //maximum number of players in game
-  std::unordered_map<size_t, Player<T> *> _players; //list of players [id, object]
+  size_t _min{0};                     //minimum number of players in game
+  size_t _max{0};                     //maximum number of players in game
+  std::vector<Player<T> *> _players;  //list of players, index is the seat
+  std::unique_ptr<seat_table> _seats; //piece value -> seat, behind a pointer so a move takes 8 bytes not 2 KB
+
+private:
+  inline void _Free() noexcept
+  {
+    for (auto &value : _players)
+      delete value;
+    _players.clear();
+    _ClearSeats();
+  }
+
+  inline void _ClearSeats() noexcept
+  {
+    if (!_seats)
+      return;
+    if constexpr (kByteTable)
+      _seats->fill(-1);
+    else
+      _seats->clear();
+  }
+
+  inline void _Seat(Player<T> *P)
+  {
+    P->set_seat(_players.size());
+    _players.push_back(P);
+    _MapPieces(*P);
+  }
+
+  //slow path of SeatOf, the table is not written so const callers may share it across threads
+  inline int_t _FindSeat(const Piece<T> &piece) const
+  {
+    for (const auto &P : _players)
+      for (const auto &p : P->pieces())
+        if (p->get() == piece.get())
+          return int_t(P->seat());
+    return -1;
+  }
+
+  inline void _MapPieces(const Player<T> &P)
+  {
+    if (!_seats)
+    {
+      _seats.reset(new seat_table);
+      _ClearSeats();
+    }
+    for (const auto &piece : P.pieces())
+      if constexpr (kByteTable)
+      {
+        auto &seat = (*_seats)[static_cast<unsigned char>(piece->get())];
+        if (seat < 0)
+          seat = int_t(P.seat());
+      }
+      else
+        _seats->insert({piece->get(), int_t(P.seat())});
+  }
 };
 
 BG_END
@@ -0,0 +1,379 @@
+/**
+ * @file bgpool.h
+ * @brief Work stealing thread pool with priorities, shared by search, self play and analysis
+ * @date 2026-10-19
+ */
+
+#ifndef BG_POOL_H_
+#define BG_POOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "bgtypes.h"
+
+BG_BEGIN
+
+namespace priority
+{
+  enum class Enum
+  {
+    HIGH,   //interactive moves
+    NORMAL, //searches
+    LOW,    //bulk analysis, self play
+    SIZE
+  };
+
+  inline const char *ToString(Enum value) noexcept
+  {
+    switch (value)
+    {
+    case Enum::HIGH:
+      return "HIGH";
+    case Enum::NORMAL:
+      return "NORMAL";
+    case Enum::LOW:
+      return "LOW";
+    default:
+      return "UNKNOWN";
+    }
+  }
+} // namespace priority
+
+/**
+ * @brief fixed set of workers, each with its own deque per priority
+ * @details a worker pops its newest task (LIFO, cache warm), idle workers take the oldest
+ * task of the injection queue or of another worker (FIFO), higher priorities first everywhere,
+ * a worker with nothing to do sleeps on a condition variable instead of spinning,
+ * use ThreadPool::Shared() so every subsystem of a process shares the same cores
+ * @code .cpp
+ * auto &pool = ThreadPool::Shared();
+ * pool.Submit([] { work(); }, priority::Enum::LOW);
+ * auto f = pool.Async([] { return 42; });
+ * pool.ParallelFor(n, [&](size_t i) { out[i] = f(i); });
+ * @endcode
+ */
+class ThreadPool
+{
+public:
+  using Task = std::function<void()>;
+  static constexpr size_t kPriorities = size_t(priority::Enum::SIZE);
+
+  struct Options
+  {
+    size_t threads{0}; //0 for one per hardware thread
+    bool pin{false};   //bind worker i to cpu i % cpus, Linux only
+  };
+
+  struct Stats
+  {
+    struct Worker
+    {
+      std::uint64_t executed; //tasks run
+      std::uint64_t stolen;   //tasks taken from another worker
+      size_t depth;           //tasks waiting in its deques
+    };
+    std::vector<Worker> workers;
+    size_t injected{0};        //tasks waiting in the injection queue
+    std::uint64_t sleeps{0};   //times a worker went idle
+  };
+
+  //-------------------CONSTRUCTORS------------------
+
+  ThreadPool() : ThreadPool(Options{}) {}
+
+  explicit ThreadPool(const Options &o)
+  {
+    const size_t n = o.threads ? o.threads : std::max(1u, std::thread::hardware_concurrency());
+    _queues.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+      _queues.emplace_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < n; ++i)
+      _workers.emplace_back([this, i, pin = o.pin] { _Loop(i, pin); });
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief [virtual] runs what is queued, then joins the workers
+   */
+  virtual ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _stop = true;
+    }
+    _cv.notify_all();
+    for (auto &w : _workers)
+      w.join();
+  }
+
+  //process wide pool, one worker per hardware thread
+  static ThreadPool &Shared()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  //-----------------------GETTERS-------------------------
+
+  inline size_t size() const noexcept { return _workers.size(); }
+
+  //index of the calling worker of this pool, or -1
+  inline int_t WorkerIndex() const noexcept { return _current.pool == this ? int_t(_current.index) : -1; }
+
+  //-----------------------FUNCTIONS-----------------------
+
+  /**
+   * @brief queues a task, on the caller's deque when called from a worker
+   */
+  void Submit(Task task, priority::Enum p = priority::Enum::NORMAL)
+  {
+    const int_t w = WorkerIndex();
+    Queue &q = w >= 0 ? *_queues[size_t(w)] : _injected;
+    {
+      std::lock_guard<std::mutex> lock{q.mutex};
+      q.tasks[size_t(p)].push_back(std::move(task));
+    }
+    _queued.fetch_add(1, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock{_mutex}; //no lost wake up against _Loop's wait
+    }
+    _cv.notify_one();
+  }
+
+  /**
+   * @brief queues fn and returns its result as a future
+   */
+  template <class Fn>
+  auto Async(Fn &&fn, priority::Enum p = priority::Enum::NORMAL)
+  {
+    using R = decltype(fn());
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<Fn>(fn));
+    auto future = task->get_future();
+    Submit([task] { (*task)(); }, p);
+    return future;
+  }
+
+  /**
+   * @brief runs one queued task on the calling thread
+   * @return false if there was none
+   */
+  bool RunOne()
+  {
+    Task task;
+    const int_t w = WorkerIndex();
+    if (!_Take(w, task))
+      return false;
+    task();
+    if (w >= 0)
+      _queues[size_t(w)]->executed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /**
+   * @brief fn(i) for i in [0, n), returns when all are done
+   * @details the caller runs queued tasks while it waits, so nested calls from workers do not deadlock
+   */
+  template <class Fn>
+  void ParallelFor(size_t n, Fn &&fn, priority::Enum p = priority::Enum::NORMAL)
+  {
+    struct Group
+    {
+      std::atomic<size_t> left;
+      std::mutex mutex;
+      std::condition_variable cv;
+    };
+    auto group = std::make_shared<Group>();
+    group->left = n;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      auto part = [group, i, &fn] {
+        fn(i);
+        if (group->left.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+          std::lock_guard<std::mutex> lock{group->mutex};
+          group->cv.notify_all();
+        }
+      };
+      Submit(part, p);
+    }
+
+    while (group->left.load(std::memory_order_acquire))
+    {
+      if (RunOne())
+        continue;
+      std::unique_lock<std::mutex> lock{group->mutex};
+      group->cv.wait_for(lock, std::chrono::milliseconds(1), [&] { return !group->left.load(std::memory_order_acquire); });
+    }
+  }
+
+  /**
+   * @brief counters and queue depths, for tuning
+   */
+  Stats Snapshot() const
+  {
+    Stats s;
+    for (const auto &q : _queues)
+      s.workers.push_back({q->executed.load(std::memory_order_relaxed), q->stolen.load(std::memory_order_relaxed), q->Depth()});
+    s.injected = _injected.Depth();
+    s.sleeps = _sleeps.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  std::string Report() const
+  {
+    const Stats s = Snapshot();
+    std::ostringstream out;
+    out << "{\"injected\":" << s.injected << ",\"sleeps\":" << s.sleeps << ",\"workers\":[";
+    for (size_t i = 0; i < s.workers.size(); ++i)
+      out << (i ? "," : "") << "{\"executed\":" << s.workers[i].executed << ",\"stolen\":" << s.workers[i].stolen
+          << ",\"depth\":" << s.workers[i].depth << "}";
+    out << "]}";
+    return out.str();
+  }
+
+protected:
+  struct Queue
+  {
+    mutable std::mutex mutex;
+    std::deque<Task> tasks[kPriorities];
+    std::atomic<std::uint64_t> executed{0};
+    std::atomic<std::uint64_t> stolen{0};
+
+    inline size_t Depth() const
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      size_t n = 0;
+      for (const auto &d : tasks)
+        n += d.size();
+      return n;
+    }
+  };
+
+  struct Current
+  {
+    const ThreadPool *pool;
+    size_t index;
+  };
+  inline static thread_local Current _current{nullptr, 0};
+
+  std::vector<std::unique_ptr<Queue>> _queues; //one per worker
+  Queue _injected;                             //tasks from other threads
+  std::vector<std::thread> _workers;
+  std::atomic<size_t> _queued{0}; //tasks in any queue
+  std::atomic<std::uint64_t> _sleeps{0};
+  std::mutex _mutex; //guards sleeping
+  std::condition_variable _cv;
+  bool _stop{false};
+
+private:
+  //-------------------FUNCTIONS--------------------
+
+  void _Loop(size_t i, bool pin)
+  {
+    _current = {this, i};
+    if (pin)
+      _Pin(i);
+
+    for (;;)
+    {
+      Task task;
+      if (_Take(int_t(i), task))
+      {
+        task();
+        _queues[i]->executed.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock{_mutex};
+      if (_stop && !_queued.load(std::memory_order_acquire))
+        return;
+      _sleeps.fetch_add(1, std::memory_order_relaxed);
+      _cv.wait(lock, [this] { return _stop || _queued.load(std::memory_order_acquire); });
+    }
+  }
+
+  //own newest, then injected oldest, then another worker's oldest, by priority
+  bool _Take(int_t self, Task &task)
+  {
+    if (!_queued.load(std::memory_order_acquire))
+      return false;
+
+    for (size_t p = 0; p < kPriorities; ++p)
+    {
+      if (self >= 0 && _Pop(*_queues[size_t(self)], p, task, true))
+        return true;
+      if (_Pop(_injected, p, task, false))
+        return true;
+
+      const size_t n = _queues.size(), start = self >= 0 ? size_t(self) + 1 : 0;
+      for (size_t k = 0; k < n; ++k)
+      {
+        const size_t victim = (start + k) % n;
+        if (int_t(victim) != self && _Pop(*_queues[victim], p, task, false))
+        {
+          if (self >= 0)
+            _queues[size_t(self)]->stolen.fetch_add(1, std::memory_order_relaxed);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  inline bool _Pop(Queue &q, size_t p, Task &task, bool newest)
+  {
+    std::lock_guard<std::mutex> lock{q.mutex};
+    auto &d = q.tasks[p];
+    if (d.empty())
+      return false;
+    if (newest)
+    {
+      task = std::move(d.back());
+      d.pop_back();
+    }
+    else
+    {
+      task = std::move(d.front());
+      d.pop_front();
+    }
+    _queued.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+  }
+
+  static void _Pin(size_t i)
+  {
+#if defined(__linux__)
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(i % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)i;
+#endif
+  }
+};
+
+BG_END
+
+#endif //BG_POOL_H_
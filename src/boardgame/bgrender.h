@@ -0,0 +1,208 @@
+/**
+ * @file bgrender.h
+ * @brief Board renderer writing one preallocated buffer per frame
+ * @date 2026-10-19
+ */
+
+#ifndef BG_RENDER_H_
+#define BG_RENDER_H_
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "bgtypes.h"
+#include "bgboard.h"
+#include "bgpiece.h"
+
+BG_BEGIN
+
+namespace render
+{
+  enum class Enum
+  {
+    FULL,  //whole board every frame, fine for logs and pipes
+    ANSI,  //whole board once, then only the changed cells through cursor moves
+    QUIET, //nothing is formatted or written
+  };
+
+  inline const char *ToString(Enum value) noexcept
+  {
+    switch (value)
+    {
+    case Enum::FULL:
+      return "FULL";
+    case Enum::ANSI:
+      return "ANSI";
+    case Enum::QUIET:
+      return "QUIET";
+    }
+    return "UNKNOWN";
+  }
+} // namespace render
+
+//character of a cell, '.' when empty
+template <class T>
+inline char Glyph(const Piece<T> *piece) noexcept { return piece ? char(piece->get()) : '.'; }
+
+/**
+ * @brief draws a Board<T> or SparseBoard<T> of any bounded size, every frame is a single fwrite
+ * @code .cpp
+ * Renderer<Piece<char>> view{stdout, render::Enum::ANSI, true};
+ * view.Draw(*game.board()); //after every move
+ * @endcode
+ *
+ * @tparam T board cell type, Glyph(const T*) must exist
+ */
+template <class T>
+class Renderer
+{
+public:
+  /**
+   * @param out where frames go
+   * @param mode
+   * @param bottom_up row 0 drawn last, as in games that fill from the bottom
+   */
+  explicit Renderer(std::FILE *out = stdout, render::Enum mode = render::Enum::FULL, bool bottom_up = false)
+      : _out{out}, _mode{mode}, _bottom_up{bottom_up} {}
+
+  //-----------------------GETTERS-------------------------
+
+  inline auto mode() const noexcept { return _mode; }
+  //last formatted frame
+  inline const auto &buffer() const noexcept { return _buf; }
+
+  //-----------------------SETTERS-------------------------
+
+  //the next ANSI frame redraws everything
+  inline void set_mode(render::Enum mode) noexcept
+  {
+    _mode = mode;
+    _shadow.clear();
+  }
+
+  //-----------------------FUNCTIONS-----------------------
+
+  /**
+   * @brief formats and writes the board
+   * @tparam B Board<T>, SparseBoard<T> or anything with rows(), cols() and at(row, col) giving a const T*
+   */
+  template <class B>
+  void Draw(const B &board)
+  {
+    if (_mode == render::Enum::QUIET)
+      return;
+    if (_mode == render::Enum::ANSI && _shadow.size() == board.rows() * board.cols())
+      _Changes(board);
+    else
+      Format(board);
+
+    if (!_buf.empty())
+    {
+      std::fwrite(_buf.data(), 1, _buf.size(), _out);
+      std::fflush(_out);
+    }
+  }
+
+  /**
+   * @brief whole board as text, without writing it
+   * @return const std::string& valid until the next call
+   */
+  template <class B>
+  const std::string &Format(const B &board)
+  {
+    const size_t rows = board.rows(), cols = board.cols();
+    const size_t line = 2 * cols + 2;
+    _buf.clear();
+    _buf.reserve((rows + 2) * line + 16);
+    _shadow.assign(rows * cols, '.');
+
+    if (_mode == render::Enum::ANSI)
+      _buf += "\x1b[2J\x1b[H";
+
+    //column numbers, last digit only past 9
+    for (size_t c = 0; c < cols; ++c)
+    {
+      _buf += ' ';
+      _buf += char('0' + (c + 1) % 10);
+    }
+    _buf += '\n';
+
+    for (size_t i = 0; i < rows; ++i)
+    {
+      const size_t r = _bottom_up ? rows - 1 - i : i;
+      for (size_t c = 0; c < cols; ++c)
+      {
+        const char g = Glyph(board.at(r, c));
+        _shadow[r * cols + c] = g;
+        _buf += '|';
+        _buf += g;
+      }
+      _buf += "|\n";
+    }
+
+    for (size_t c = 0; c < cols; ++c)
+      _buf += "+-";
+    _buf += "+\n";
+    return _buf;
+  }
+
+protected:
+  std::FILE *_out;
+  render::Enum _mode;
+  bool _bottom_up;
+  std::string _buf;          //frame being written, capacity kept between frames
+  std::vector<char> _shadow; //glyphs on screen, row major
+
+private:
+  //cursor moves and glyphs for the cells that differ from the screen
+  template <class B>
+  void _Changes(const B &board)
+  {
+    const size_t rows = board.rows(), cols = board.cols();
+    _buf.clear();
+
+    char pos[32];
+    for (size_t r = 0; r < rows; ++r)
+      for (size_t c = 0; c < cols; ++c)
+      {
+        const char g = Glyph(board.at(r, c));
+        if (_shadow[r * cols + c] == g)
+          continue;
+        _shadow[r * cols + c] = g;
+        //1 based screen position, the header is line 1
+        const size_t line = 2 + (_bottom_up ? rows - 1 - r : r);
+        std::snprintf(pos, sizeof(pos), "\x1b[%zu;%zuH", line, 2 * c + 2);
+        _buf += pos;
+        _buf += g;
+      }
+
+    if (!_buf.empty())
+    {
+      //park the cursor below the board
+      std::snprintf(pos, sizeof(pos), "\x1b[%zu;1H", rows + 3);
+      _buf += pos;
+    }
+  }
+};
+
+/**
+ * @brief one full frame to stdout
+ */
+template <class T>
+inline void print(const Board<T> &board)
+{
+  Renderer<T>{stdout}.Draw(board);
+}
+
+template <class T>
+std::ostream &operator<<(std::ostream &out, const Board<T> &board)
+{
+  Renderer<T> r{nullptr, render::Enum::FULL};
+  return out << r.Format(board);
+}
+
+BG_END
+
+#endif //BG_RENDER_H_
@@ -0,0 +1,374 @@
+/**
+ * @file bgsparse.h
+ * @brief Implementation of SparseBoard Class
+ * @date 2026-10-19
+ */
+
+#ifndef BG_SPARSE_H_
+#define BG_SPARSE_H_
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "bgtypes.h"
+#include "bgboard.h"
+#include "bgstats.h"
+
+BG_BEGIN
+
+/**
+ * @brief Board storing only the occupied cells, in an open addressing hash table
+ * @details the getters, insert, erase, copy and move of Board, so code templated on the board,
+ * Game<T, B> and Renderer, takes either, memory and copy cost grow with the number of stones
+ * instead of rows x cols
+ * @note cells are written through insert and erase only, at() is read only even on a non-const
+ * board, where Board hands out a writable T*&, so code writing through at() does not compile
+ * @code .cpp
+ * SparseBoard<Piece<char>> gomoku{19, 19};
+ * class Gomoku : public Game<char, SparseBoard<Piece<char>>> {...};
+ * SparseBoard<Piece<char>> infinite{SparseBoard<Piece<char>>::kUnbounded, SparseBoard<Piece<char>>::kUnbounded};
+ *
+ * virtual ~SparseBoard();
+ * virtual SparseBoard* copy() const;
+ * virtual SparseBoard* move();
+ * @endcode
+ *
+ * @tparam T is the type of which board will be created
+ */
+template <class T>
+class SparseBoard
+{
+public:
+  static constexpr size_t kUnbounded = 0xFFFFFFFFu; //rows or cols without a limit
+
+  //-------------------CONSTRUCTORS------------------
+
+  SparseBoard() {}
+
+  /**
+   * @brief Construct a new SparseBoard object
+   *
+   * @param rows number of rows, or kUnbounded
+   * @param cols number of cols, or kUnbounded
+   */
+  SparseBoard(size_t rows, size_t cols) : _rows{rows}, _cols{cols} {}
+
+  /**
+   * @brief [deep copy] Construct a new SparseBoard object, O(stones)
+   */
+  SparseBoard(const SparseBoard<T> &other) : _rows{other._rows}, _cols{other._cols} { _CopyFrom(other); }
+
+  SparseBoard<T> &operator=(const SparseBoard<T> &other)
+  {
+    if (this != &other)
+    {
+      // Free the existing resource.
+      clear();
+
+      // Copy the data source object.
+      _rows = other._rows;
+      _cols = other._cols;
+      _CopyFrom(other);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Move to a new SparseBoard object, O(1)
+   */
+  SparseBoard(SparseBoard<T> &&other) noexcept { *this = std::move(other); }
+  SparseBoard<T> &operator=(SparseBoard<T> &&other) noexcept
+  {
+    if (this != &other)
+    {
+      // Free the existing resource.
+      clear();
+
+      // Steal the table from the source object.
+      _rows = other._rows;
+      _cols = other._cols;
+      _size = other._size;
+      _slots.swap(other._slots);
+
+      // Leave the source object empty.
+      other._size = 0;
+      other._rows = other._cols = 0;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief [virtual] Destroy the SparseBoard object
+   */
+  virtual ~SparseBoard() { clear(); }
+
+  //-----------------------GETTERS-------------------------
+
+  //number of rows
+  inline auto rows() const noexcept { return _rows; }
+  //number of columns
+  inline auto cols() const noexcept { return _cols; }
+  //number of occupied cells
+  inline auto size() const noexcept { return _size; }
+  //bytes held by the table
+  inline auto memory() const noexcept { return _slots.capacity() * sizeof(Slot); }
+
+  /**
+   * @brief const reference to value at row,col
+   * @return T* const&, nullptr when the cell is empty
+   */
+  inline const auto &at(size_t row, size_t col) const
+  {
+    _Check(row, col);
+    const size_t i = _Find(_Key(row, col));
+    return i == kNone ? _kNull : _slots[i].val;
+  }
+
+  //-----------------------SETTERS-------------------------
+
+  /**
+   * @brief changes the bounds, stones outside the new bounds are deleted
+   * @param rows
+   * @param cols
+   */
+  inline void resize(size_t myrows, size_t mycols)
+  {
+    _rows = myrows;
+    _cols = mycols;
+    for (size_t i = 0; i < _slots.size();)
+      if (_slots[i].key != kEmpty && (_Row(_slots[i].key) >= _rows || _Col(_slots[i].key) >= _cols))
+        _EraseAt(i); //the next entry may have shifted into i
+      else
+        ++i;
+  }
+
+  /**
+   * @brief Set the board object
+   * @param val [deep copy of T]
+   */
+  inline void insert(size_t row, size_t col, const T &val)
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    auto &cell = _Slot(row, col);
+    delete cell;
+    cell = new T{val};
+  }
+
+  /**
+   * @brief Set the board object
+   * @param val [copy of T] (move constructor)
+   */
+  inline void insert(size_t row, size_t col, T &&val)
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    auto &cell = _Slot(row, col);
+    delete cell;
+    cell = new T{std::forward<T>(val)};
+  }
+
+  //empties the cell and frees its slot
+  inline void erase(size_t row, size_t col)
+  {
+    const size_t i = _Find(_Key(row, col));
+    if (i != kNone)
+      _EraseAt(i);
+  }
+
+  /**
+   * @brief resets the board, keeps the bounds
+   */
+  void clear() noexcept
+  {
+    for (auto &slot : _slots)
+      if (slot.key != kEmpty)
+        delete slot.val;
+    _slots.clear();
+    _slots.shrink_to_fit();
+    _size = 0;
+  }
+
+  //------------------------MEMBER FUNCTIONS-----------------------------
+
+  /**
+   * @brief check if the board contains or not, O(stones)
+   */
+  bool IsFound(const T &val) const
+  {
+    for (const auto &slot : _slots)
+      if (slot.key != kEmpty && slot.val && *slot.val == val)
+        return true;
+    return false;
+  }
+
+  /**
+   * @brief returns a position of val, O(stones)
+   * @return {row,col} | {-1,-1}
+   */
+  Point Find(const T &val) const
+  {
+    for (const auto &slot : _slots)
+      if (slot.key != kEmpty && slot.val && *slot.val == val)
+        return {int_t(_Row(slot.key)), int_t(_Col(slot.key))};
+    return {-1, -1};
+  }
+
+  /**
+   * @brief calls fn(row, col, const T&) for every occupied cell, in no particular order
+   */
+  template <class Fn>
+  void ForEach(Fn &&fn) const
+  {
+    for (const auto &slot : _slots)
+      if (slot.key != kEmpty && slot.val)
+        fn(_Row(slot.key), _Col(slot.key), *slot.val);
+  }
+
+  //-------------------OPERATORS-------------------------
+
+  inline const auto &operator()(size_t row, size_t col) const { return at(row, col); }
+
+  //--------------------VIRTUAL--------------------------
+
+  virtual SparseBoard<T> *copy() const
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new SparseBoard<T>{*this};
+  }
+  virtual SparseBoard<T> *move()
+  {
+    _ISSTAT_ stats::Count(stats::Enum::ALLOC);
+    return new SparseBoard<T>{std::forward<SparseBoard<T>>(*this)};
+  }
+
+protected:
+  struct Slot
+  {
+    std::uint64_t key; //row << 32 | col, kEmpty if unused
+    T *val;
+  };
+
+  static constexpr std::uint64_t kEmpty = ~std::uint64_t{0};
+  static constexpr size_t kNone = ~size_t{0};
+  inline static T *const _kNull = nullptr;
+
+  size_t _rows{0};          //rows size
+  size_t _cols{0};          //column size
+  size_t _size{0};          //slots in use
+  std::vector<Slot> _slots; //power of two, at most half full
+
+private:
+  //-------------------FUNCTIONS--------------------
+
+  static constexpr std::uint64_t _Key(size_t row, size_t col) { return std::uint64_t(row) << 32 | std::uint64_t(col & 0xFFFFFFFFu); }
+  static constexpr size_t _Row(std::uint64_t key) { return size_t(key >> 32); }
+  static constexpr size_t _Col(std::uint64_t key) { return size_t(key & 0xFFFFFFFFu); }
+
+  //splitmix64 finalizer, neighbouring cells land far apart
+  static inline size_t _Hash(std::uint64_t key) noexcept
+  {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return size_t(key);
+  }
+
+  //the cell's value, a new empty slot if it had none
+  inline T *&_Slot(size_t row, size_t col)
+  {
+    _Check(row, col);
+    return _slots[_FindOrAdd(_Key(row, col))].val;
+  }
+
+  inline void _Check(size_t row, size_t col) const
+  {
+    if (row >= _rows || col >= _cols)
+      throw std::out_of_range{"SparseBoard::at"};
+  }
+
+  size_t _Find(std::uint64_t key) const noexcept
+  {
+    if (_slots.empty())
+      return kNone;
+    const size_t mask = _slots.size() - 1;
+    for (size_t i = _Hash(key) & mask;; i = (i + 1) & mask)
+    {
+      if (_slots[i].key == key)
+        return i;
+      if (_slots[i].key == kEmpty)
+        return kNone;
+    }
+  }
+
+  size_t _FindOrAdd(std::uint64_t key)
+  {
+    if ((_size + 1) * 2 > _slots.size())
+      _Grow();
+
+    const size_t mask = _slots.size() - 1;
+    for (size_t i = _Hash(key) & mask;; i = (i + 1) & mask)
+    {
+      if (_slots[i].key == key)
+        return i;
+      if (_slots[i].key == kEmpty)
+      {
+        _slots[i] = {key, nullptr};
+        ++_size;
+        return i;
+      }
+    }
+  }
+
+  void _Grow()
+  {
+    std::vector<Slot> old;
+    old.swap(_slots);
+    _slots.assign(old.empty() ? 16 : old.size() * 2, Slot{kEmpty, nullptr});
+
+    const size_t mask = _slots.size() - 1;
+    for (const auto &slot : old)
+      if (slot.key != kEmpty)
+      {
+        size_t i = _Hash(slot.key) & mask;
+        while (_slots[i].key != kEmpty)
+          i = (i + 1) & mask;
+        _slots[i] = slot;
+      }
+  }
+
+  //backward shift deletion, keeps probe chains intact without tombstones
+  void _EraseAt(size_t i)
+  {
+    delete _slots[i].val;
+    --_size;
+
+    const size_t mask = _slots.size() - 1;
+    for (size_t j = (i + 1) & mask; _slots[j].key != kEmpty; j = (j + 1) & mask)
+    {
+      const size_t home = _Hash(_slots[j].key) & mask;
+      //move j into the hole at i if its home is not within (i, j]
+      if (((j - home) & mask) >= ((j - i) & mask))
+      {
+        _slots[i] = _slots[j];
+        i = j;
+      }
+    }
+    _slots[i] = {kEmpty, nullptr};
+  }
+
+  void _CopyFrom(const SparseBoard<T> &other)
+  {
+    _slots = other._slots;
+    _size = other._size;
+    for (auto &slot : _slots)
+      if (slot.key != kEmpty && slot.val)
+        slot.val = new T{*slot.val};
+  }
+};
+
+BG_END
+
+#endif //BG_SPARSE_H_
@@ -0,0 +1,306 @@
+/**
+ * @file bgstats.h
+ * @brief Hot path counters and latency histograms, compiled in with BG_STATS=1
+ * @date 2026-10-19
+ */
+
+#ifndef BG_STATS_H_
+#define BG_STATS_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bgtypes.h"
+
+BG_BEGIN
+
+/**
+ * @brief usage, every call compiles away unless BG_STATS is 1
+ * @code .cpp
+ * _ISSTAT_ stats::Count(stats::Enum::APPLY);
+ *
+ * std::uint64_t start = 0;
+ * _ISSTAT_ start = stats::Now();
+ * ...
+ * _ISSTAT_ stats::Latency(playerid, stats::Now() - start);
+ *
+ * std::cout << stats::Json();
+ * @endcode
+ */
+namespace stats
+{
+  enum class Enum
+  {
+    MAKE_MOVE,
+    APPLY,
+    IS_VALID,
+    IS_WINNING,
+    GET_POSSIBLE_MOVES,
+    ALLOC, //heap objects created by the framework
+
+    SIZE
+  };
+
+  inline const char *ToString(Enum value) noexcept
+  {
+    switch (value)
+    {
+    case Enum::MAKE_MOVE:
+      return "MakeMove";
+    case Enum::APPLY:
+      return "Apply";
+    case Enum::IS_VALID:
+      return "IsValid";
+    case Enum::IS_WINNING:
+      return "IsWinning";
+    case Enum::GET_POSSIBLE_MOVES:
+      return "GetPossibleMoves";
+    case Enum::ALLOC:
+      return "Alloc";
+    case Enum::SIZE:
+      break;
+    }
+    return "unknown";
+  }
+
+  constexpr std::size_t kCounters = std::size_t(Enum::SIZE);
+
+  //monotonic nanoseconds
+  inline std::uint64_t Now() noexcept
+  {
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now().time_since_epoch())
+                             .count());
+  }
+
+  /**
+   * @brief log2 buckets of nanoseconds, bucket i holds [2^i, 2^(i+1))
+   */
+  struct Histogram
+  {
+    std::array<std::uint64_t, 64> buckets{};
+    std::uint64_t count{0};
+    std::uint64_t total_ns{0};
+    std::uint64_t max_ns{0};
+
+    inline void Add(std::uint64_t ns) noexcept
+    {
+      int b = 0;
+      while (b < 63 && (ns >> (b + 1)))
+        ++b;
+      ++buckets[b];
+      ++count;
+      total_ns += ns;
+      max_ns = ns > max_ns ? ns : max_ns;
+    }
+
+    inline void Merge(const Histogram &other) noexcept
+    {
+      for (std::size_t b = 0; b < buckets.size(); ++b)
+        buckets[b] += other.buckets[b];
+      count += other.count;
+      total_ns += other.total_ns;
+      max_ns = other.max_ns > max_ns ? other.max_ns : max_ns;
+    }
+
+    //upper bound of the bucket holding the p-th percentile, p in [0,1]
+    inline std::uint64_t Percentile(double p) const noexcept
+    {
+      const auto rank = std::uint64_t(p * double(count));
+      std::uint64_t seen = 0;
+      for (std::size_t b = 0; b < buckets.size(); ++b)
+        if ((seen += buckets[b]) > rank)
+          return b >= 63 ? max_ns : std::min(max_ns, (std::uint64_t{2} << b) - 1);
+      return max_ns;
+    }
+  };
+
+  /**
+   * @brief aggregated view of every thread's counters
+   */
+  struct Snapshot
+  {
+    std::array<std::uint64_t, kCounters> counts{};
+    std::map<size_t, Histogram> latency; //SuggestMove latency per player id
+
+    inline void Merge(const Snapshot &other)
+    {
+      for (std::size_t i = 0; i < kCounters; ++i)
+        counts[i] += other.counts[i];
+      for (const auto &[key, hist] : other.latency)
+        latency[key].Merge(hist);
+    }
+
+    inline auto operator[](Enum e) const noexcept { return counts[std::size_t(e)]; }
+  };
+
+  class Local;
+
+  /**
+   * @brief owns the list of live thread blocks and the totals of exited threads
+   */
+  class Registry
+  {
+  public:
+    static Registry &Get()
+    {
+      static Registry registry;
+      return registry;
+    }
+
+    inline void Add(Local *l)
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _live.push_back(l);
+    }
+
+    inline void Remove(Local *l, const Snapshot &last)
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _retired.Merge(last);
+      for (auto it = _live.begin(); it != _live.end(); ++it)
+        if (*it == l)
+        {
+          _live.erase(it);
+          break;
+        }
+    }
+
+    inline Snapshot Aggregate();
+    inline void Reset();
+
+  private:
+    std::mutex _mutex;
+    std::vector<Local *> _live; //blocks of running threads
+    Snapshot _retired;          //totals of exited threads
+  };
+
+  /**
+   * @brief counters of one thread, only that thread writes them
+   */
+  class Local
+  {
+  public:
+    Local() { Registry::Get().Add(this); }
+    ~Local() { Registry::Get().Remove(this, Read()); }
+
+    Local(const Local &) = delete;
+    Local &operator=(const Local &) = delete;
+
+    //single writer, a relaxed load and store is a plain increment
+    inline void Count(Enum e, std::uint64_t n) noexcept
+    {
+      auto &c = _counts[std::size_t(e)];
+      c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    inline void Latency(size_t playerid, std::uint64_t ns)
+    {
+      std::lock_guard<std::mutex> lock{_mutex}; //uncontended unless someone aggregates
+      _latency[playerid].Add(ns);
+    }
+
+    inline Snapshot Read()
+    {
+      Snapshot s;
+      for (std::size_t i = 0; i < kCounters; ++i)
+        s.counts[i] = _counts[i].load(std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock{_mutex};
+      for (const auto &[key, hist] : _latency)
+        s.latency[key] = hist;
+      return s;
+    }
+
+    inline void Reset()
+    {
+      for (auto &c : _counts)
+        c.store(0, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock{_mutex};
+      _latency.clear();
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, kCounters> _counts{};
+    std::mutex _mutex;
+    std::unordered_map<size_t, Histogram> _latency;
+  };
+
+  inline Snapshot Registry::Aggregate()
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    Snapshot total = _retired;
+    for (auto *l : _live)
+      total.Merge(l->Read());
+    return total;
+  }
+
+  inline void Registry::Reset()
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    _retired = Snapshot{};
+    for (auto *l : _live)
+      l->Reset();
+  }
+
+  //counters of the calling thread
+  inline Local &ThisThread()
+  {
+    thread_local Local local;
+    return local;
+  }
+
+  inline void Count(Enum e, std::uint64_t n = 1) noexcept { ThisThread().Count(e, n); }
+  inline void Latency(size_t playerid, std::uint64_t ns) { ThisThread().Latency(playerid, ns); }
+  inline Snapshot Aggregate() { return Registry::Get().Aggregate(); }
+  inline void Reset() { Registry::Get().Reset(); }
+
+  /**
+   * @brief every counter and histogram of every thread as one JSON object
+   * @return std::string
+   */
+  inline std::string Json()
+  {
+    const Snapshot s = Aggregate();
+    std::ostringstream out;
+
+    out << "{\"counters\":{";
+    for (std::size_t i = 0; i < kCounters; ++i)
+      out << (i ? "," : "") << '"' << ToString(Enum(i)) << "\":" << s.counts[i];
+
+    out << "},\"suggest_move_ns\":{";
+    bool first = true;
+    for (const auto &[key, h] : s.latency)
+    {
+      out << (first ? "" : ",") << '"' << key << "\":{"
+          << "\"count\":" << h.count
+          << ",\"mean\":" << (h.count ? h.total_ns / h.count : 0)
+          << ",\"p50\":" << h.Percentile(0.50)
+          << ",\"p90\":" << h.Percentile(0.90)
+          << ",\"p99\":" << h.Percentile(0.99)
+          << ",\"max\":" << h.max_ns
+          << ",\"buckets\":[";
+      int last = 63;
+      while (last > 0 && !h.buckets[last])
+        --last;
+      for (int b = 0; b <= last; ++b)
+        out << (b ? "," : "") << h.buckets[b];
+      out << "]}";
+      first = false;
+    }
+    out << "}}";
+    return out.str();
+  }
+} //namespace stats
+
+BG_END
+
+#endif //BG_STATS_H_
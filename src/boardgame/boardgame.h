@@ -8,8 +8,9 @@
 #include "bgtypes.h"
 #include "bgmove.h"
 #include "bgboard.h"
+#include "bgsparse.h"
 #include "bgplayer.h"
 #include "bgplayers.h"
 #include "bgame.h"
-#include "bgprint.h"
+#include "bgrender.h"
 #include "color.h"
\ No newline at end of file
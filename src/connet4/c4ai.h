@@ -0,0 +1,598 @@
+#ifndef C4_AI_
+#define C4_AI_
+
+#include <string>
+#include <climits>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../boardgame/bgpool.h"
+#include "c4types.h"
+#include "c4game.h"
+#include "c4eval.h"
+#include "c4tablebase.h"
+#include "c4nnue.h"
+#include "c4ttable.h"
+#include "c4cache.h"
+
+namespace c4
+{
+  class C4Game;
+
+  namespace driver
+  {
+    enum class Enum
+    {
+      ALPHABETA,  //full window alpha beta
+      PVS,        //principal variation search, null windows after the first child
+      MTDF,       //null windows only, converging on the score, deepens one ply at a time
+      ASPIRATION, //PVS deepening with a window around the previous depth's score
+    };
+
+    inline const char *ToString(Enum value) noexcept
+    {
+      switch (value)
+      {
+      case Enum::ALPHABETA:
+        return "ALPHABETA";
+      case Enum::PVS:
+        return "PVS";
+      case Enum::MTDF:
+        return "MTDF";
+      case Enum::ASPIRATION:
+        return "ASPIRATION";
+      }
+      return "UNKNOWN";
+    }
+  } // namespace driver
+
+  /**
+   * @brief computer player, depth limited negamax with alpha beta pruning
+   * @details `diff_level` is the search depth in plies, positions at the horizon are scored by C4Evaluator,
+   * asynchronous searches deepen one ply at a time and publish every finished depth,
+   * the driver picks how the root is searched, all but ALPHABETA use a transposition table
+   */
+  class C4AI : public C4Player
+  {
+  public:
+    static constexpr int kWin = 1000000; //score of a won position, minus the plies to get there
+
+    C4AI(std::string name, std::size_t diff_level = 8, C4Piece p = {'A'}, const C4Weights &w = {})
+        : Player(name, diff_level, p), _eval{w} {}
+
+    inline const auto &evaluator() const noexcept { return _eval; }
+    inline void set_weights(const C4Weights &w) noexcept { _eval.set_weights(w); }
+    //exact scores for late positions, not owned, nullptr to search everything
+    inline void set_tablebase(const C4Tablebase *tb) noexcept { _tb = tb; }
+    //horizon scoring by a network instead of C4Evaluator, nullptr to go back
+    inline void set_network(std::shared_ptr<const C4Nnue> net) noexcept { _net = std::move(net); }
+    inline const auto &network() const noexcept { return _net; }
+    inline auto driver() const noexcept { return _driver; }
+    //gives the player a table of `megabytes` if it has none and the driver needs one, 0 for none
+    inline void set_driver(driver::Enum d, std::size_t megabytes = 16)
+    {
+      _driver = d;
+      if (!_tt && megabytes && d != driver::Enum::ALPHABETA)
+        _tt = std::make_shared<C4TTable>(megabytes);
+    }
+    inline const auto &ttable() const noexcept { return _tt; }
+    //shared with other players searching with the same evaluator, nullptr to search without one
+    inline void set_ttable(std::shared_ptr<C4TTable> tt) noexcept { _tt = std::move(tt); }
+    inline const auto &move_cache() const noexcept { return _cache; }
+    /**
+     * @brief finished searches shared with other players and sessions, nullptr to always search
+     * @param tag tells apart players whose weights, network or tablebase differ, the cache already
+     * tells apart depths and drivers
+     */
+    inline void set_move_cache(std::shared_ptr<C4MoveCache> cache, std::uint64_t tag = 0) noexcept
+    {
+      _cache = std::move(cache);
+      _cache_tag = tag;
+    }
+
+    C4Move *SuggestMove(const BGame &state) const override
+    {
+      const C4Game *c4state = dynamic_cast<const C4Game *>(&state);
+      if (!c4state)
+        return nullptr;
+
+      const int col = BestColumn(*c4state);
+      if (col < 0)
+        return nullptr;
+      return new C4Move(c4state->AvailableRow(col), col, *(_pieces.front()));
+    }
+
+    C4Move *SuggestMove(const BGame &state, bg::MoveSearch<char> &search) const override
+    {
+      const C4Game *c4state = dynamic_cast<const C4Game *>(&state);
+      if (!c4state)
+        return nullptr;
+
+      const int col = BestColumn(*c4state, &search);
+      if (col < 0)
+        return nullptr;
+      return new C4Move(c4state->AvailableRow(col), col, *(_pieces.front()));
+    }
+
+    //wins, the only block and the only legal column need no search
+    C4Move *Immediate(const BGame &state) const override
+    {
+      const C4Game *c4state = dynamic_cast<const C4Game *>(&state);
+      if (!c4state)
+        return nullptr;
+
+      const int col = ForcedColumn(*c4state);
+      if (col < 0)
+        return nullptr;
+      return new C4Move(c4state->AvailableRow(col), col, *(_pieces.front()));
+    }
+
+    /**
+     * @brief column every search would pick
+     * @return -1 if the position needs a search
+     */
+    static int ForcedColumn(const C4Game &game)
+    {
+      using namespace bitboard;
+
+      const bits_t mask = game.mask(), possible = Possible(mask);
+      bits_t pick = Threats(game.own(), mask) & possible; //win now
+      if (!pick)
+      {
+        pick = Threats(game.opp(), mask) & possible; //block, unless there are two
+        if (pick & (pick - 1))
+          return -1;
+      }
+      if (!pick && !(possible & (possible - 1)))
+        pick = possible; //only one column left
+
+      for (int c = 0; c < kCols; ++c)
+        if (pick & Column(c))
+          return c;
+      return -1;
+    }
+
+    /**
+     * @brief what a search found
+     */
+    struct Result
+    {
+      int column{-1};          //-1 if the board is full
+      int score{0};            //negamax score of `column` for the side to move
+      int depth{0};            //last finished depth
+      std::uint64_t nodes{0};  //positions visited
+    };
+
+    /**
+     * @brief searches with the player's driver
+     * @param game
+     * @param search if given, deepens from 1 ply, publishes each depth and stops when asked
+     */
+    Result Search(const C4Game &game, bg::MoveSearch<char> *search = nullptr) const
+    {
+      return Search(game.own(), game.mask(), search);
+    }
+
+    /**
+     * @brief searches a position given as bitboards, for callers without a C4Game
+     * @param own stones of the side to move
+     * @param mask all stones
+     * @param search if given, deepens from 1 ply, publishes each depth and stops when asked
+     */
+    Result Search(bits_t own, bits_t mask, bg::MoveSearch<char> *search = nullptr) const
+    {
+      using namespace bitboard;
+
+      const int depth = std::max(1, int(_diff_level));
+      const std::uint32_t level = std::uint32_t(depth) | std::uint32_t(_driver) << 8;
+
+      //a position some player like this one already searched to the end
+      C4MoveCache::Entry hit;
+      if (_cache && _cache->Find(own, mask, level, _cache_tag, hit))
+      {
+        if (search && hit.column >= 0)
+          search->Publish(C4Move(Count(mask & Column(hit.column)), hit.column, *(_pieces.front())), hit.depth);
+        return {hit.column, hit.score, hit.depth, 0};
+      }
+
+      //root children ordered by the batch heuristic
+      const auto heuristic = ScoreChildren(own, mask, _eval.weights().batch());
+      int order[kCols], n = 0;
+      for (int c = 0; c < kCols; ++c)
+        if (heuristic[c] != INT_MIN)
+          order[n++] = c;
+      std::stable_sort(order, order + n, [&](int a, int b) { return heuristic[a] > heuristic[b]; });
+
+      Budget budget{search};
+      budget.tt = _tt.get();
+      budget.pvs = _driver != driver::Enum::ALPHABETA;
+
+      //network accumulators, one per stone count, children are one Push away from their parent
+      std::vector<C4Nnue::Accumulator> stack;
+      if (_net)
+      {
+        stack.resize(kCells + 1);
+        const int ply = Count(mask);
+        _net->Refresh(stack[ply], ply & 1 ? own ^ mask : own, ply & 1 ? own : own ^ mask);
+        budget.acc = stack.data();
+      }
+
+      //drivers that need a guess always deepen, the others only to stay interruptible
+      const bool deepen = search || _driver == driver::Enum::MTDF || _driver == driver::Enum::ASPIRATION;
+
+      Result r;
+      r.column = n ? order[0] : -1;
+      for (int d = deepen ? 1 : depth; d <= depth && !(search && search->Stopped()); ++d)
+      {
+        int value;
+        const int c = _Drive(own, mask, order, n, d, r.score, budget, value);
+        if (budget.stopped)
+          break; //the unfinished depth is not trusted
+        r.column = c;
+        r.score = value;
+        r.depth = d;
+        if (search)
+          search->Publish(C4Move(Count(mask & Column(c)), c, *(_pieces.front())), d);
+
+        //search the last best first, more cutoffs at the next depth
+        int *at = std::find(order, order + n, c);
+        std::rotate(order, at, at + 1);
+      }
+      r.nodes = budget.nodes;
+      //a stopped search is not the answer the level asks for
+      if (_cache && (r.depth == depth || n == 0))
+        _cache->Insert(own, mask, level, _cache_tag, {r.column, r.score, r.depth});
+      return r;
+    }
+
+    /**
+     * @brief best column for the side to move
+     * @param game
+     * @param search if given, deepens from 1 ply, publishes each depth and stops when asked
+     * @param score [out] negamax score of the returned column for the side to move, if given
+     * @return -1 if the board is full
+     */
+    int BestColumn(const C4Game &game, bg::MoveSearch<char> *search = nullptr, int *score = nullptr) const
+    {
+      const Result r = Search(game, search);
+      if (score)
+        *score = r.score;
+      return r.column;
+    }
+
+    /**
+     * @brief score and principal variation of one root column, see Analyze
+     */
+    struct Line
+    {
+      int column{-1};
+      int score{0};           //negamax score of playing `column`, for the side to move
+      int depth{0};           //plies searched, `column` included
+      std::uint64_t nodes{0}; //positions visited
+      std::vector<int> pv;    //columns from `column` on, as far as the table knows them
+    };
+
+    /**
+     * @brief scores every legal column, the columns searched in parallel on the shared pool
+     * @details unlike Search every column gets a full window, so every score is exact at the depth,
+     * not just a bound, the searches share the player's table or one made for the call,
+     * each column is searched at least two plies deep
+     * @param own stones of the side to move
+     * @param mask all stones
+     * @param on_line if given, called with each line as soon as its column is scored,
+     * one call at a time, from pool threads
+     * @return one line per legal column, best first
+     */
+    std::vector<Line> Analyze(bits_t own, bits_t mask, const std::function<void(const Line &)> &on_line = {}) const
+    {
+      using namespace bitboard;
+
+      const int ply = Count(mask);
+      const std::size_t depth = std::max<std::size_t>(2, _diff_level);
+      const std::shared_ptr<C4TTable> tt = _tt ? _tt : std::make_shared<C4TTable>();
+
+      const bits_t possible = Possible(mask);
+      int cols[kCols], n = 0;
+      for (const int c : kOrder)
+        if (possible & Column(c))
+          cols[n++] = c;
+
+      if (IsAligned(own ^ mask))
+        n = 0; //the game is over
+      std::vector<Line> lines(static_cast<std::size_t>(n));
+      std::mutex streaming;
+      bg::ThreadPool::Shared().ParallelFor(std::size_t(n), [&](std::size_t i) {
+        Line &line = lines[i];
+        line.column = cols[i];
+        line.depth = 1;
+        const bits_t cell = possible & Column(line.column);
+        int reply = -1;
+        if (IsAligned(own | cell))
+          line.score = kWin - ply - 1;
+        else if (ply + 1 < kCells)
+        {
+          //the child is searched by a copy of this player one ply shallower
+          C4AI child{*this};
+          child.set_diff_level(depth - 1);
+          child.set_ttable(tt);
+          const Result r = child.Search(own ^ mask, mask | cell);
+          line.score = -r.score;
+          line.depth = r.depth + 1;
+          line.nodes = r.nodes;
+          reply = r.column;
+        }
+        line.pv = _Pv(own, mask, line.column, reply, *tt);
+
+        if (on_line)
+        {
+          std::lock_guard<std::mutex> lock{streaming};
+          on_line(line);
+        }
+      });
+
+      std::stable_sort(lines.begin(), lines.end(), [](const Line &a, const Line &b) { return a.score > b.score; });
+      return lines;
+    }
+
+    //Analyze of a game's position
+    std::vector<Line> Analyze(const C4Game &game, const std::function<void(const Line &)> &on_line = {}) const
+    {
+      return Analyze(game.own(), game.mask(), on_line);
+    }
+
+    C4AI *copy() const override
+    {
+      return new C4AI(*this);
+    }
+    C4AI *move() override
+    {
+      return new C4AI(std::forward<C4AI>(*this));
+    }
+
+  protected:
+    static constexpr int kInf = kWin + 1; //outside every score
+
+    //columns from the center out, better moves first means more cutoffs
+    static constexpr int kOrder[bitboard::kCols] = {3, 2, 4, 1, 5, 0, 6};
+
+    //state of one search, lets an asynchronous search stop, polled every 1024 nodes
+    struct Budget
+    {
+      const bg::MoveSearch<char> *search{nullptr};
+      std::uint64_t nodes{0};
+      std::uint64_t poll{1024};
+      bool stopped{false};
+      C4Nnue::Accumulator *acc{nullptr}; //indexed by stones played, nullptr without a network
+      C4TTable *tt{nullptr};             //nullptr to search without one
+      bool pvs{false};                   //null window for every child but the first
+
+      inline bool Stop() noexcept
+      {
+        if (search && !stopped && nodes >= poll)
+        {
+          poll = nodes + 1024;
+          stopped = search->Stopped();
+        }
+        return stopped;
+      }
+    };
+
+    //one depth with the player's driver, `guess` is the score of the previous depth
+    int _Drive(bits_t own, bits_t mask, const int *order, int n, int depth, int guess, Budget &budget, int &value) const
+    {
+      if (depth == 1 || _driver == driver::Enum::ALPHABETA || _driver == driver::Enum::PVS)
+        return _Root(own, mask, order, n, depth, -kInf, kInf, budget, value);
+
+      if (_driver == driver::Enum::ASPIRATION)
+      {
+        //window around the guess, widened on the side that failed
+        int delta = kAspiration, lo = guess - delta, hi = guess + delta;
+        for (;;)
+        {
+          const int c = _Root(own, mask, order, n, depth, lo, hi, budget, value);
+          if (budget.stopped || (value > lo && value < hi))
+            return c;
+          delta *= 4;
+          if (value <= lo)
+            lo = std::max(-kInf, guess - delta);
+          else
+            hi = std::min(kInf, guess + delta);
+          if (lo == -kInf && hi == kInf)
+            return _Root(own, mask, order, n, depth, lo, hi, budget, value);
+        }
+      }
+
+      //MTD(f): null windows from the guess, bisecting once the score is bracketed
+      int lo = -kInf, hi = kInf, g = guess, best = n ? order[0] : -1;
+      while (lo < hi)
+      {
+        const int beta = lo > -kInf && hi < kInf ? lo + (hi - lo + 1) / 2 : std::max(g, lo + 1);
+        const int c = _Root(own, mask, order, n, depth, beta - 1, beta, budget, g);
+        if (budget.stopped)
+          break;
+        if (g < beta)
+          hi = g;
+        else
+        {
+          lo = g;
+          best = c; //only a fail high proves a column
+        }
+      }
+      value = lo > -kInf ? lo : hi;
+      return best;
+    }
+
+    //best of the root columns in `order` within (alpha, beta), fail soft, the first one if the budget ran out
+    int _Root(bits_t own, bits_t mask, const int *order, int n, int depth, int alpha, int beta, Budget &budget, int &value) const
+    {
+      using namespace bitboard;
+
+      const int ply = Count(mask);
+      int best = n ? order[0] : -1, top = -kInf;
+      value = 0;
+      for (int i = 0; i < n; ++i)
+      {
+        const int c = order[i];
+        const bits_t cell = (mask + BottomOf(c)) & Column(c);
+        if (IsAligned(own | cell))
+        {
+          value = kWin - ply - 1;
+          return c; //immediate win
+        }
+
+        if (budget.acc)
+          _net->Push(budget.acc[ply], budget.acc[ply + 1], ply & 1, cell);
+        const int score = _Child(own, mask, cell, depth, alpha, beta, i == 0, budget);
+        if (budget.stopped)
+          return best;
+        if (score > top)
+        {
+          top = score;
+          best = c;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta)
+          break;
+      }
+      if (n)
+        value = top;
+      return best;
+    }
+
+    //score of the child reached by `cell`, a null window first under pvs
+    inline int _Child(bits_t own, bits_t mask, bits_t cell, int depth, int alpha, int beta, bool first, Budget &budget) const
+    {
+      if (!budget.pvs || first || beta - alpha <= 1)
+        return -_Negamax(own ^ mask, mask | cell, depth - 1, -beta, -alpha, budget);
+
+      const int score = -_Negamax(own ^ mask, mask | cell, depth - 1, -alpha - 1, -alpha, budget);
+      if (score > alpha && score < beta && !budget.stopped)
+        return -_Negamax(own ^ mask, mask | cell, depth - 1, -beta, -alpha, budget);
+      return score;
+    }
+
+    /**
+     * @brief negamax score of a position for the side to move, fail soft
+     *
+     * @param own stones of the side to move
+     * @param mask all stones
+     * @param depth plies left before the heuristic takes over
+     * @param budget the score is meaningless once `budget.stopped`
+     */
+    int _Negamax(bits_t own, bits_t mask, int depth, int alpha, int beta, Budget &budget) const
+    {
+      using namespace bitboard;
+
+      ++budget.nodes;
+      const int ply = Count(mask);
+      if (ply == kCells)
+        return 0; //draw
+
+      const bits_t possible = (mask + kBottom) & kBoard;
+      if (Threats(own, mask) & possible)
+        return kWin - ply - 1; //wins with the next stone
+
+      int t;
+      if (_tb && ply >= _tb->min_stones() && _tb->Probe(own, mask, t))
+        return C4Tablebase::ToSearchScore(t, kWin);
+
+      if (depth <= 0)
+        return budget.acc ? _net->Evaluate(budget.acc[ply], ply & 1) : _eval.Evaluate(own, own ^ mask);
+      if (budget.Stop())
+        return 0;
+
+      //a stored result may answer the window, or at least name the column to try first
+      const std::uint64_t key = budget.tt ? Key(own, mask) : 0;
+      int first = -1;
+      C4TTable::Entry e;
+      if (budget.tt && budget.tt->Probe(key, e))
+      {
+        if (e.depth >= depth && (e.bound == bound::Enum::EXACT || (e.bound == bound::Enum::LOWER && e.score >= beta) ||
+                                 (e.bound == bound::Enum::UPPER && e.score <= alpha)))
+          return e.score;
+        first = e.best;
+      }
+
+      const int alpha0 = alpha;
+      int top = -kInf, best = -1, i = 0;
+      for (int k = -1; k < kCols; ++k)
+      {
+        const int c = k < 0 ? first : kOrder[k];
+        if (c < 0 || (k >= 0 && c == first))
+          continue;
+        const bits_t cell = possible & Column(c);
+        if (!cell)
+          continue;
+
+        if (budget.acc)
+          _net->Push(budget.acc[ply], budget.acc[ply + 1], ply & 1, cell);
+        const int score = _Child(own, mask, cell, depth, alpha, beta, i++ == 0, budget);
+        if (budget.stopped)
+          return 0;
+        if (score > top)
+        {
+          top = score;
+          best = c;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta)
+          break;
+      }
+
+      if (budget.tt)
+        budget.tt->Store(key, top, depth, top <= alpha0 ? bound::Enum::UPPER : top >= beta ? bound::Enum::LOWER : bound::Enum::EXACT, best);
+      return top;
+    }
+
+    /**
+     * @brief `col`, `reply` then the best moves stored in `tt`, up to a win, a full board or a position it does not know
+     * @param reply best answer to `col`, -1 to look it up, roots are not stored in the table
+     */
+    static std::vector<int> _Pv(bits_t own, bits_t mask, int col, int reply, const C4TTable &tt)
+    {
+      using namespace bitboard;
+
+      std::vector<int> pv;
+      for (;;)
+      {
+        const bits_t possible = Possible(mask), cell = possible & Column(col);
+        pv.push_back(col);
+        if (IsAligned(own | cell) || Count(mask) + 1 == kCells)
+          break;
+        own ^= mask;
+        mask |= cell;
+
+        //a win in one is never stored, the search returns before it reaches the table
+        const bits_t wins = Threats(own, mask) & Possible(mask);
+        C4TTable::Entry e;
+        if (wins)
+          col = Count((wins & (0 - wins)) - 1) / kStride;
+        else if (reply >= 0 && (Possible(mask) & Column(reply)))
+          col = reply;
+        else if (!tt.Probe(Key(own, mask), e) || e.best < 0 || !(Possible(mask) & Column(e.best)))
+          break;
+        else
+          col = e.best;
+        reply = -1;
+      }
+      return pv;
+    }
+
+  protected:
+    static constexpr int kAspiration = 16; //first half width of an aspiration window
+
+    C4Evaluator _eval;                             //horizon scoring
+    const C4Tablebase *_tb{nullptr};               //endgame scores
+    std::shared_ptr<const C4Nnue> _net;            //horizon scoring instead of _eval if set
+    driver::Enum _driver{driver::Enum::ALPHABETA}; //how the root is searched
+    std::shared_ptr<C4TTable> _tt;                 //shared by copies of the player
+    std::shared_ptr<C4MoveCache> _cache;           //finished searches, shared across sessions
+    std::uint64_t _cache_tag{0};                   //what else tells this player's searches apart
+  };
+
+} // namespace c4
+
+#endif //C4_AI_
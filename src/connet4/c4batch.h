@@ -0,0 +1,296 @@
+#ifndef C4_BATCH_H_
+#define C4_BATCH_H_
+
+#include <array>
+#include <vector>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include "../boardgame/bgcpu.h"
+#include "c4bitboard.h"
+
+namespace c4
+{
+  using bitboard::bits_t;
+
+  /**
+   * @brief weights of the heuristic features scored by EvaluateBatch
+   */
+  struct C4BatchWeights
+  {
+    int threat{8}; //empty cell completing an open three
+    int center{3}; //stone in the center column
+    int parity{4}; //threat on a row of the owner's parity (odd for 1st player, even for 2nd)
+  };
+
+  /**
+   * @brief positions to be scored together, kept as structure of arrays
+   * @details own[i] are the stones of the side to move in position i, opp[i] the other side's
+   */
+  class C4PositionBatch
+  {
+  public:
+    inline auto size() const noexcept { return _own.size(); }
+    inline bool empty() const noexcept { return _own.empty(); }
+    inline const bits_t *own() const noexcept { return _own.data(); }
+    inline const bits_t *opp() const noexcept { return _opp.data(); }
+
+    inline void reserve(std::size_t n)
+    {
+      _own.reserve(n);
+      _opp.reserve(n);
+    }
+
+    inline void clear() noexcept
+    {
+      _own.clear();
+      _opp.clear();
+    }
+
+    inline void push(bits_t own, bits_t opp)
+    {
+      _own.push_back(own);
+      _opp.push_back(opp);
+    }
+
+  private:
+    std::vector<bits_t> _own; //stones of the side to move
+    std::vector<bits_t> _opp; //stones of the side that just moved
+  };
+
+  namespace batch
+  {
+    //score of one position, from the side to move's point of view
+    inline int Scalar(bits_t own, bits_t opp, const C4BatchWeights &w) noexcept
+    {
+      using namespace bitboard;
+
+      const bits_t mask = own | opp;
+      const bits_t tOwn = Threats(own, mask), tOpp = Threats(opp, mask);
+      const bool first = (Count(mask) & 1) == 0; //side to move made the first move
+      const bits_t ownGood = first ? kOddRows : kEvenRows;
+      const bits_t oppGood = first ? kEvenRows : kOddRows;
+
+      return w.threat * (Count(tOwn) - Count(tOpp)) +
+             w.center * (Count(own & kCenter) - Count(opp & kCenter)) +
+             w.parity * (Count(tOwn & ownGood) - Count(tOpp & oppGood));
+    }
+
+    inline void Scalar(const bits_t *own, const bits_t *opp, std::size_t n, int *scores, const C4BatchWeights &w) noexcept
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        scores[i] = Scalar(own[i], opp[i], w);
+    }
+
+#if BG_X86
+
+    //-------------------------SSE4.1-----------------------------
+
+    BG_TARGET_SSE41 inline __m128i Popcount128(__m128i v) noexcept
+    {
+      const __m128i lut = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+      const __m128i low = _mm_set1_epi8(0x0f);
+      const __m128i lo = _mm_and_si128(v, low);
+      const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), low);
+      const __m128i cnt = _mm_add_epi8(_mm_shuffle_epi8(lut, lo), _mm_shuffle_epi8(lut, hi));
+      return _mm_sad_epu8(cnt, _mm_setzero_si128()); //one count per 64bit lane
+    }
+
+    template <int S>
+    BG_TARGET_SSE41 inline __m128i Lines128(__m128i s) noexcept
+    {
+      __m128i p = _mm_and_si128(_mm_slli_epi64(s, S), _mm_slli_epi64(s, 2 * S));
+      __m128i r = _mm_and_si128(p, _mm_slli_epi64(s, 3 * S));
+      r = _mm_or_si128(r, _mm_and_si128(p, _mm_srli_epi64(s, S)));
+      p = _mm_and_si128(_mm_srli_epi64(s, S), _mm_srli_epi64(s, 2 * S));
+      r = _mm_or_si128(r, _mm_and_si128(p, _mm_slli_epi64(s, S)));
+      return _mm_or_si128(r, _mm_and_si128(p, _mm_srli_epi64(s, 3 * S)));
+    }
+
+    BG_TARGET_SSE41 inline __m128i Threats128(__m128i s, __m128i mask) noexcept
+    {
+      using namespace bitboard;
+
+      __m128i r = _mm_and_si128(_mm_and_si128(_mm_slli_epi64(s, 1), _mm_slli_epi64(s, 2)), _mm_slli_epi64(s, 3));
+      r = _mm_or_si128(r, Lines128<kStride>(s));
+      r = _mm_or_si128(r, Lines128<kRows>(s));
+      r = _mm_or_si128(r, Lines128<kRows + 2>(s));
+      return _mm_andnot_si128(mask, _mm_and_si128(r, _mm_set1_epi64x(kBoard)));
+    }
+
+    BG_TARGET_SSE41 inline void SSE41(const bits_t *own, const bits_t *opp, std::size_t n, int *scores, const C4BatchWeights &w) noexcept
+    {
+      using namespace bitboard;
+
+      const __m128i one = _mm_set1_epi64x(1), zero = _mm_setzero_si128();
+      const __m128i center = _mm_set1_epi64x(kCenter);
+      const __m128i odd = _mm_set1_epi64x(kOddRows), even = _mm_set1_epi64x(kEvenRows);
+      const __m128i wT = _mm_set1_epi64x(w.threat), wC = _mm_set1_epi64x(w.center), wP = _mm_set1_epi64x(w.parity);
+
+      std::size_t i = 0;
+      for (; i + 2 <= n; i += 2)
+      {
+        const __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i *>(own + i));
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(opp + i));
+        const __m128i mask = _mm_or_si128(o, x);
+        const __m128i tOwn = Threats128(o, mask), tOpp = Threats128(x, mask);
+
+        const __m128i first = _mm_cmpeq_epi64(_mm_and_si128(Popcount128(mask), one), zero);
+        const __m128i ownGood = _mm_or_si128(_mm_and_si128(first, odd), _mm_andnot_si128(first, even));
+        const __m128i oppGood = _mm_or_si128(_mm_and_si128(first, even), _mm_andnot_si128(first, odd));
+
+        const __m128i dT = _mm_sub_epi64(Popcount128(tOwn), Popcount128(tOpp));
+        const __m128i dC = _mm_sub_epi64(Popcount128(_mm_and_si128(o, center)), Popcount128(_mm_and_si128(x, center)));
+        const __m128i dP = _mm_sub_epi64(Popcount128(_mm_and_si128(tOwn, ownGood)), Popcount128(_mm_and_si128(tOpp, oppGood)));
+
+        const __m128i sum = _mm_add_epi64(_mm_mul_epi32(dT, wT), _mm_add_epi64(_mm_mul_epi32(dC, wC), _mm_mul_epi32(dP, wP)));
+
+        alignas(16) std::int64_t out[2];
+        _mm_store_si128(reinterpret_cast<__m128i *>(out), sum);
+        scores[i] = int(out[0]);
+        scores[i + 1] = int(out[1]);
+      }
+      Scalar(own + i, opp + i, n - i, scores + i, w);
+    }
+
+    //-------------------------AVX2-------------------------------
+
+    BG_TARGET_AVX2 inline __m256i Popcount256(__m256i v) noexcept
+    {
+      const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+      const __m256i low = _mm256_set1_epi8(0x0f);
+      const __m256i lo = _mm256_and_si256(v, low);
+      const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+      const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi));
+      return _mm256_sad_epu8(cnt, _mm256_setzero_si256()); //one count per 64bit lane
+    }
+
+    template <int S>
+    BG_TARGET_AVX2 inline __m256i Lines256(__m256i s) noexcept
+    {
+      __m256i p = _mm256_and_si256(_mm256_slli_epi64(s, S), _mm256_slli_epi64(s, 2 * S));
+      __m256i r = _mm256_and_si256(p, _mm256_slli_epi64(s, 3 * S));
+      r = _mm256_or_si256(r, _mm256_and_si256(p, _mm256_srli_epi64(s, S)));
+      p = _mm256_and_si256(_mm256_srli_epi64(s, S), _mm256_srli_epi64(s, 2 * S));
+      r = _mm256_or_si256(r, _mm256_and_si256(p, _mm256_slli_epi64(s, S)));
+      return _mm256_or_si256(r, _mm256_and_si256(p, _mm256_srli_epi64(s, 3 * S)));
+    }
+
+    BG_TARGET_AVX2 inline __m256i Threats256(__m256i s, __m256i mask) noexcept
+    {
+      using namespace bitboard;
+
+      __m256i r = _mm256_and_si256(_mm256_and_si256(_mm256_slli_epi64(s, 1), _mm256_slli_epi64(s, 2)), _mm256_slli_epi64(s, 3));
+      r = _mm256_or_si256(r, Lines256<kStride>(s));
+      r = _mm256_or_si256(r, Lines256<kRows>(s));
+      r = _mm256_or_si256(r, Lines256<kRows + 2>(s));
+      return _mm256_andnot_si256(mask, _mm256_and_si256(r, _mm256_set1_epi64x(kBoard)));
+    }
+
+    BG_TARGET_AVX2 inline void AVX2(const bits_t *own, const bits_t *opp, std::size_t n, int *scores, const C4BatchWeights &w) noexcept
+    {
+      using namespace bitboard;
+
+      const __m256i one = _mm256_set1_epi64x(1), zero = _mm256_setzero_si256();
+      const __m256i center = _mm256_set1_epi64x(kCenter);
+      const __m256i odd = _mm256_set1_epi64x(kOddRows), even = _mm256_set1_epi64x(kEvenRows);
+      const __m256i wT = _mm256_set1_epi64x(w.threat), wC = _mm256_set1_epi64x(w.center), wP = _mm256_set1_epi64x(w.parity);
+
+      std::size_t i = 0;
+      for (; i + 4 <= n; i += 4)
+      {
+        const __m256i o = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(own + i));
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(opp + i));
+        const __m256i mask = _mm256_or_si256(o, x);
+        const __m256i tOwn = Threats256(o, mask), tOpp = Threats256(x, mask);
+
+        const __m256i first = _mm256_cmpeq_epi64(_mm256_and_si256(Popcount256(mask), one), zero);
+        const __m256i ownGood = _mm256_or_si256(_mm256_and_si256(first, odd), _mm256_andnot_si256(first, even));
+        const __m256i oppGood = _mm256_or_si256(_mm256_and_si256(first, even), _mm256_andnot_si256(first, odd));
+
+        const __m256i dT = _mm256_sub_epi64(Popcount256(tOwn), Popcount256(tOpp));
+        const __m256i dC = _mm256_sub_epi64(Popcount256(_mm256_and_si256(o, center)), Popcount256(_mm256_and_si256(x, center)));
+        const __m256i dP = _mm256_sub_epi64(Popcount256(_mm256_and_si256(tOwn, ownGood)), Popcount256(_mm256_and_si256(tOpp, oppGood)));
+
+        const __m256i sum = _mm256_add_epi64(_mm256_mul_epi32(dT, wT), _mm256_add_epi64(_mm256_mul_epi32(dC, wC), _mm256_mul_epi32(dP, wP)));
+
+        alignas(32) std::int64_t out[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(out), sum);
+        for (int k = 0; k < 4; ++k)
+          scores[i + k] = int(out[k]);
+      }
+      SSE41(own + i, opp + i, n - i, scores + i, w);
+    }
+
+#endif //BG_X86
+  } // namespace batch
+
+  /**
+   * @brief scores n positions at once, from the side to move's point of view
+   *
+   * @param own stones of the side to move, n entries
+   * @param opp stones of the other side, n entries
+   * @param n number of positions
+   * @param scores [out] n entries
+   * @param w feature weights
+   * @param isa kernel to use, defaults to the widest one the cpu supports
+   */
+  inline void EvaluateBatch(const bits_t *own, const bits_t *opp, std::size_t n, int *scores,
+                            const C4BatchWeights &w = {}, bg::simd::Enum isa = bg::simd::Best()) noexcept
+  {
+#if BG_X86
+    if (isa == bg::simd::Enum::AVX2)
+      return batch::AVX2(own, opp, n, scores, w);
+    if (isa == bg::simd::Enum::SSE41)
+      return batch::SSE41(own, opp, n, scores, w);
+#endif
+    batch::Scalar(own, opp, n, scores, w);
+  }
+
+  /**
+   * @brief scores every position of the batch
+   * @param positions
+   * @param scores [out] resized to positions.size()
+   * @param w feature weights
+   */
+  inline void EvaluateBatch(const C4PositionBatch &positions, std::vector<int> &scores, const C4BatchWeights &w = {})
+  {
+    scores.resize(positions.size());
+    EvaluateBatch(positions.own(), positions.opp(), positions.size(), scores.data(), w);
+  }
+
+  /**
+   * @brief heuristic score of every move of the side to move, from its point of view
+   * @param own stones of the side to move
+   * @param mask all stones
+   * @return INT_MIN for full columns
+   */
+  inline std::array<int, bitboard::kCols> ScoreChildren(bits_t own, bits_t mask, const C4BatchWeights &w = {})
+  {
+    using namespace bitboard;
+
+    std::array<int, kCols> scores;
+    scores.fill(INT_MIN);
+
+    //the side to move becomes the opponent in the child
+    bits_t next[kCols], last[kCols];
+    int cols[kCols], child[kCols], n = 0;
+    const bits_t possible = Possible(mask);
+    for (int c = 0; c < kCols; ++c)
+      if (possible & Column(c))
+      {
+        next[n] = own ^ mask;
+        last[n] = own | (possible & Column(c));
+        cols[n++] = c;
+      }
+
+    EvaluateBatch(next, last, std::size_t(n), child, w);
+    for (int i = 0; i < n; ++i)
+      scores[cols[i]] = -child[i];
+    return scores;
+  }
+} // namespace c4
+
+#endif //C4_BATCH_H_
@@ -0,0 +1,324 @@
+#ifndef C4_BENCH_H_
+#define C4_BENCH_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../boardgame/bgbench.h"
+#include "../boardgame/bglog.h"
+#include "../boardgame/bgstats.h"
+#include "c4ai.h"
+#include "c4game.h"
+#include "c4input.h"
+#include "c4snapshot.h"
+
+#if defined(__linux__)
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+#include "c4client.h"
+#include "c4server.h"
+#endif
+
+namespace c4
+{
+  //positions every benchmark runs on, 1 based columns from the empty board
+  inline const std::vector<std::string> &C4BenchOpenings()
+  {
+    static const std::vector<std::string> openings{
+        "",
+        "4",
+        "44",
+        "4453",
+        "3344552",
+        "444333",
+        "43526171",
+        "4444335",
+        "12345671",
+        "4433221155",
+    };
+    return openings;
+  }
+
+  /**
+   * @brief game with two seated AIs and the columns of `moves` played
+   * @param moves 1 based columns, see C4ReplaySource
+   */
+  inline C4Game C4BenchGame(const std::string &moves)
+  {
+    C4Game game;
+    game.insert(C4AI{"first", 1, C4Piece{'A'}});
+    game.insert(C4AI{"second", 1, C4Piece{'B'}});
+
+    auto replay = C4ReplaySource::FromString(moves);
+    int col;
+    while (game.state() == bg::game::Enum::NOTOVER && replay.Poll(col))
+      game.Play(new C4Move(game.AvailableRow(std::size_t(col)), col, *(game.players()->at(game.turning_player())->pieces().front())));
+    return game;
+  }
+
+  /**
+   * @brief totals of one search driver over C4BenchOpenings
+   */
+  struct C4DriverReport
+  {
+    driver::Enum driver;
+    std::uint64_t nodes{0};
+    std::uint64_t ns{0};
+    int agree{0}; //positions scored like ALPHABETA
+  };
+
+  /**
+   * @brief searches every opening to `depth` with every driver, a fresh table per search
+   * @param out table of the results, nullptr for none
+   */
+  inline std::vector<C4DriverReport> C4BenchDrivers(std::size_t depth, std::FILE *out = stdout)
+  {
+    const driver::Enum drivers[] = {driver::Enum::ALPHABETA, driver::Enum::PVS, driver::Enum::MTDF, driver::Enum::ASPIRATION};
+
+    std::vector<C4DriverReport> reports;
+    for (const auto d : drivers)
+      reports.push_back({d});
+
+    for (const auto &moves : C4BenchOpenings())
+    {
+      const C4Game game = C4BenchGame(moves);
+      int reference = 0;
+      for (auto &report : reports)
+      {
+        C4AI ai{"bench", depth};
+        ai.set_driver(report.driver);
+
+        const std::uint64_t start = bg::stats::Now();
+        const C4AI::Result r = ai.Search(game);
+        report.ns += bg::stats::Now() - start;
+        report.nodes += r.nodes;
+
+        if (report.driver == driver::Enum::ALPHABETA)
+          reference = r.score;
+        report.agree += r.score == reference;
+      }
+    }
+
+    if (out)
+    {
+      std::fprintf(out, "%-12s %14s %10s %10s %6s\n", "driver", "nodes", "ms", "knodes/s", "agree");
+      for (const auto &r : reports)
+        std::fprintf(out, "%-12s %14llu %10.1f %10.0f %3d/%-2zu\n", driver::ToString(r.driver), (unsigned long long)r.nodes,
+                     r.ns / 1e6, r.ns ? r.nodes * 1e6 / r.ns : 0.0, r.agree, C4BenchOpenings().size());
+    }
+    return reports;
+  }
+
+  /**
+   * @brief cost of each framework primitive on a middle game position, see bg::bench
+   * @details logging is off while measuring, pointers an operation returns are deleted outside the timing
+   */
+  inline std::vector<bg::bench::Result> C4BenchPrimitives(const bg::bench::Options &o = {})
+  {
+    using namespace bg;
+
+    const logging::Enum level = logging::Logger::Get().level();
+    logging::SetLevel(logging::Enum::OFF);
+
+    C4Game game = C4BenchGame("43526171");
+    C4Board &board = *game.board();
+    const C4Piece piece{'A'}, pieces[2] = {C4Piece{'A'}, C4Piece{'B'}};
+    const C4Move move{2, 3, piece};
+    C4Move held{move};
+    C4AI ai{"bench"};
+    const auto *players = game.players();
+    const auto *player = players->at(0);
+    std::size_t i = 0;
+
+    std::vector<bench::Result> r;
+    r.push_back(bench::Collect("Board::copy", [&] { return board.copy(); }, [](C4Board *b) { delete b; }, o));
+    r.push_back(bench::Run("Board::Board(Board&&) + operator=(Board&&)", [&] {
+      C4Board moved{std::move(board)};
+      board = std::move(moved);
+    }, o));
+    r.push_back(bench::Run("Move::Move(Move&&) + operator=(Move&&)", [&] {
+      C4Move moved{std::move(held)};
+      held = std::move(moved);
+    }, o));
+    r.push_back(bench::Run("Player::Player(Player&&) + operator=(Player&&)", [&] {
+      C4AI moved{std::move(ai)};
+      ai = std::move(moved);
+    }, o));
+    r.push_back(bench::Run("Players::Players(Players&&) + operator=(Players&&)", [&] {
+      C4Players moved{std::move(*game.players())};
+      *game.players() = std::move(moved);
+    }, o));
+    r.push_back(bench::Run("Game::Game(Game&&) + operator=(Game&&)", [&] {
+      C4Game moved{std::move(game)};
+      game = std::move(moved);
+    }, o));
+    {
+      //on a board of its own, the game's board must stay in step with its bitboards
+      C4Board scratch{C4Game::kRows, C4Game::kCols};
+      r.push_back(bench::Run("Board::insert", [&] { scratch.insert(5, i++ % C4Game::kCols, piece); }, o));
+    }
+    r.push_back(bench::Run("Board::at", [&] {
+      bench::Keep(board.at(i % C4Game::kRows, i % C4Game::kCols));
+      ++i;
+    }, o));
+    {
+      //the same position on a board holding only its stones, drawn by the same renderer
+      C4SparseBoard sparse{C4Game::kRows, C4Game::kCols};
+      for (std::size_t row = 0; row < std::size_t(C4Game::kRows); ++row)
+        for (std::size_t c = 0; c < std::size_t(C4Game::kCols); ++c)
+          if (board.at(row, c))
+            sparse.insert(row, c, *board.at(row, c));
+      Renderer<C4Piece> view{nullptr};
+
+      r.push_back(bench::Collect("SparseBoard::copy", [&] { return sparse.copy(); }, [](C4SparseBoard *b) { delete b; }, o));
+      r.push_back(bench::Run("SparseBoard::at", [&] {
+        bench::Keep(sparse.at(i % C4Game::kRows, i % C4Game::kCols));
+        ++i;
+      }, o));
+      r.push_back(bench::Run("Renderer::Format(Board)", [&] { bench::Keep(view.Format(board)); }, o));
+      r.push_back(bench::Run("Renderer::Format(SparseBoard)", [&] { bench::Keep(view.Format(sparse)); }, o));
+    }
+    r.push_back(bench::Run("Move::Move(row,col,Piece)", [&] {
+      C4Move m{2, 3, piece};
+      bench::Keep(m);
+    }, o));
+    r.push_back(bench::Run("Move::Move(const Move&)", [&] {
+      C4Move m{move};
+      bench::Keep(m);
+    }, o));
+    r.push_back(bench::Collect("Piece::copy", [&] { return piece.copy(); }, [](C4Piece *p) { delete p; }, o));
+    r.push_back(bench::Run("Players::at", [&] { bench::Keep(players->at(i++ & 1)); }, o));
+    r.push_back(bench::Run("Player::IsPlayerPiece", [&] { bench::Keep(player->IsPlayerPiece(pieces[i++ & 1])); }, o));
+    r.push_back(bench::Collect("C4Game::copy", [&] { return game.copy(); }, [](C4Game *g) { delete g; }, o));
+
+    //a legal move for the side to move, taken back so every call sees the same position
+    const int col = 3;
+    const C4Move next{game.AvailableRow(col), col, *(players->at(game.turning_player())->pieces().front())};
+    r.push_back(bench::Run("C4Game::Apply + Undo", [&] {
+      game.Apply(next);
+      game.Undo();
+    }, o));
+    r.push_back(bench::Run("C4Game::IsWinning", [&] { bench::Keep(game.IsWinning(next, game.turning_player())); }, o));
+    r.push_back(bench::Run("C4Game::IsWinningState", [&] { bench::Keep(game.IsWinningState(i++ & 1)); }, o));
+    r.push_back(bench::Collect("C4Game::GetPossibleMoves", [&] { return game.GetPossibleMoves(game.turning_player()); },
+                               [](const std::vector<C4Move *> &moves) {
+                                 for (auto *m : moves)
+                                   delete m;
+                               },
+                               o));
+    {
+      C4SnapshotSource source{game};
+      const C4Snapshot snapshot = source.Take();
+      r.push_back(bench::Collect("C4SnapshotSource::Take", [&] { return source.Take(); }, [](const C4Snapshot &) {}, o));
+      r.push_back(bench::Collect("C4Snapshot::Play", [&] { return snapshot.Play(col); }, [](const C4Snapshot &) {}, o));
+    }
+
+    logging::SetLevel(level);
+    return r;
+  }
+
+#if defined(__linux__)
+  /**
+   * @brief round trip of C4Client against a C4Server on a Unix socket, every answer checked
+   * @details `sessions` clients, each on a thread and a connection of its own, open their games,
+   * wait until every game is open, then play them at the same time, the engine opens every other
+   * one, each client then checks END and the errors for a move after the end and for a dropped session
+   * @return true | false if the server did not start, an answer broke the protocol or the games did not overlap
+   */
+  inline bool C4BenchLoopback(std::size_t sessions = 4, int level = 4)
+  {
+    using namespace wire;
+
+    C4Server::Options o;
+    o.unix_path = "/tmp/c4-loopback-" + std::to_string(::getpid()) + ".sock";
+    o.report_seconds = 0;
+    o.tt_megabytes = 16;
+    o.cache_megabytes = 1;
+    C4Server server{o};
+    if (!server.Listen())
+      return false;
+    std::thread run{[&server] { server.Run(); }};
+
+    std::atomic<bool> ok{true};
+    std::atomic<std::size_t> moves{0};
+    std::mutex mutex;
+    std::condition_variable all_open;
+    std::size_t open = 0;
+
+    //one game, false on the first answer that breaks the protocol
+    auto game = [&](std::size_t g) {
+      C4Client client;
+      const bool engine_first = g & 1;
+      Frame started{};
+      bool good = client.Connect(o.unix_path);
+      if (good)
+      {
+        started = client.Call({op::Enum::NEW, std::uint8_t(level), std::uint8_t(engine_first), 0});
+        good = started.op == op::Enum::STARTED && started.aux == std::uint8_t(engine_first);
+      }
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        if (++open == sessions)
+          all_open.notify_all();
+        all_open.wait(lock, [&] { return open == sessions; });
+      }
+      const std::uint32_t session = started.session;
+
+      //heights of the columns as both sides played them
+      int height[C4Game::kCols] = {};
+      auto play = [&height](int col) { return col >= 0 && col < C4Game::kCols && height[col]++ < C4Game::kRows; };
+
+      Frame reply{};
+      if (good && engine_first)
+        good = client.Receive(reply) && reply.op == op::Enum::MOVED && reply.session == session && play(reply.arg);
+
+      for (int ply = 0; good && (reply.op != op::Enum::MOVED || reply.aux == std::uint8_t(status::Enum::NOTOVER)); ++ply)
+      {
+        int col = int(g + std::size_t(ply)) % C4Game::kCols;
+        while (height[col] == C4Game::kRows)
+          col = (col + 1) % C4Game::kCols;
+        play(col);
+        reply = client.Call({op::Enum::MOVE, std::uint8_t(col), 0, session});
+        good = reply.op == op::Enum::MOVED && reply.session == session &&
+               (reply.arg == kNoColumn ? reply.aux != std::uint8_t(status::Enum::NOTOVER) : play(reply.arg));
+        moves.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      auto refused = [](const Frame &f, error::Enum e) { return f.op == op::Enum::ERROR && f.arg == std::uint8_t(e); };
+      good = good && refused(client.Call({op::Enum::MOVE, 0, 0, session}), error::Enum::ILLEGAL_MOVE);
+      good = good && client.Call({op::Enum::END, 0, 0, session}).op == op::Enum::ENDED;
+      good = good && refused(client.Call({op::Enum::MOVE, 0, 0, session}), error::Enum::NO_SESSION);
+      client.Close();
+      if (!good)
+        ok = false;
+    };
+
+    const std::uint64_t start = bg::stats::Now();
+    std::vector<std::thread> clients;
+    clients.reserve(sessions);
+    for (std::size_t g = 0; g < sessions; ++g)
+      clients.emplace_back(game, g);
+    for (auto &c : clients)
+      c.join();
+    const std::uint64_t ns = bg::stats::Now() - start;
+
+    server.Stop();
+    run.join();
+    ::unlink(o.unix_path.c_str());
+    if (server.peak() != sessions)
+      ok = false; //every game was open before the first move, so all of them were live at once
+    const std::size_t played = moves.load();
+    BGLOG_INFO("C4BenchLoopback", "{} sessions {} peak {} moves {} us_per_move {}", ok ? "ok" : "FAILED", sessions,
+               server.peak(), played, played ? ns / played / 1000 : 0);
+    return ok;
+  }
+#endif
+} // namespace c4
+
+#endif //C4_BENCH_H_
@@ -0,0 +1,137 @@
+#ifndef C4_BITBOARD_H_
+#define C4_BITBOARD_H_
+
+#include <cstdint>
+#include <initializer_list>
+
+namespace c4
+{
+  /* bit layout of a 6x7 position, one spare bit on top of every column
+     .  .  .  .  .  .  .
+     5 12 19 26 33 40 47
+     4 11 18 25 32 39 46
+     3 10 17 24 31 38 45
+     2  9 16 23 30 37 44
+     1  8 15 22 29 36 43
+     0  7 14 21 28 35 42   <-- row 0 is the bottom row
+  */
+  namespace bitboard
+  {
+    using bits_t = std::uint64_t;
+
+    constexpr int kRows = 6;
+    constexpr int kCols = 7;
+    constexpr int kCells = kRows * kCols;
+    constexpr int kStride = kRows + 1; //bits per column
+
+    constexpr bits_t Bottom()
+    {
+      bits_t b = 0;
+      for (int c = 0; c < kCols; ++c)
+        b |= bits_t{1} << (c * kStride);
+      return b;
+    }
+
+    constexpr bits_t kBottom = Bottom();
+    constexpr bits_t kBoard = kBottom * ((bits_t{1} << kRows) - 1);
+    constexpr bits_t kCenter = ((bits_t{1} << kRows) - 1) << ((kCols / 2) * kStride);
+    constexpr bits_t kOddRows = kBottom * 0x15;  //rows 0,2,4 (1st,3rd,5th from the bottom)
+    constexpr bits_t kEvenRows = kBottom * 0x2A; //rows 1,3,5
+
+    //single cell
+    constexpr bits_t Cell(int row, int col) { return bits_t{1} << (col * kStride + row); }
+    //all cells of a column
+    constexpr bits_t Column(int col) { return ((bits_t{1} << kRows) - 1) << (col * kStride); }
+    //lowest cell of a column
+    constexpr bits_t BottomOf(int col) { return bits_t{1} << (col * kStride); }
+    //highest cell of a column
+    constexpr bits_t TopOf(int col) { return bits_t{1} << (col * kStride + kRows - 1); }
+
+    //unique key of a position, `stones` being the stones of the side to move, never 0
+    constexpr bits_t Key(bits_t stones, bits_t mask) { return stones + mask + kBottom; }
+
+    //inverse of Key, the highest bit of every column marks its height
+    inline void Decode(bits_t key, bits_t &stones, bits_t &mask) noexcept
+    {
+      stones = mask = 0;
+      for (int c = 0; c < kCols; ++c)
+      {
+        const bits_t col = (key >> (c * kStride)) & ((bits_t{1} << kStride) - 1);
+        int h = kRows;
+        while (h > 0 && !(col >> h))
+          --h;
+        const bits_t filled = (bits_t{1} << h) - 1;
+        mask |= filled << (c * kStride);
+        stones |= (col & filled) << (c * kStride);
+      }
+    }
+
+    //cells where the next stone can go
+    constexpr bits_t Possible(bits_t mask) { return (mask + kBottom) & kBoard; }
+
+    //the board seen in a mirror, column c becomes kCols - 1 - c
+    constexpr bits_t Mirror(bits_t b)
+    {
+      bits_t r = 0;
+      for (int c = 0; c < kCols; ++c)
+        r |= ((b >> (c * kStride)) & ((bits_t{1} << kStride) - 1)) << ((kCols - 1 - c) * kStride);
+      return r;
+    }
+
+    inline int Count(bits_t b) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return __builtin_popcountll(b);
+#else
+      int n = 0;
+      for (; b; b &= b - 1)
+        ++n;
+      return n;
+#endif
+    }
+
+    //true if `stones` contain four in a row
+    constexpr bool IsAligned(bits_t stones)
+    {
+      bits_t m = stones & (stones >> kStride); //horizontal
+      if (m & (m >> (2 * kStride)))
+        return true;
+      m = stones & (stones >> kRows); //diagonal /
+      if (m & (m >> (2 * kRows)))
+        return true;
+      m = stones & (stones >> (kRows + 2)); //diagonal \ (wraps)
+      if (m & (m >> (2 * (kRows + 2))))
+        return true;
+      m = stones & (stones >> 1); //vertical
+      if (m & (m >> 2))
+        return true;
+      return false;
+    }
+
+    /**
+     * @brief empty cells that would complete four in a row for `stones`
+     * @param stones
+     * @param mask all stones on the board
+     * @return bits_t
+     */
+    constexpr bits_t Threats(bits_t stones, bits_t mask)
+    {
+      //vertical
+      bits_t r = (stones << 1) & (stones << 2) & (stones << 3);
+
+      //horizontal and both diagonals
+      for (int s : {kStride, kRows, kRows + 2})
+      {
+        bits_t p = (stones << s) & (stones << (2 * s));
+        r |= p & (stones << (3 * s));
+        r |= p & (stones >> s);
+        p = (stones >> s) & (stones >> (2 * s));
+        r |= p & (stones << s);
+        r |= p & (stones >> (3 * s));
+      }
+      return r & (kBoard ^ mask);
+    }
+  } // namespace bitboard
+} // namespace c4
+
+#endif //C4_BITBOARD_H_
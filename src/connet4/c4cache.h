@@ -0,0 +1,227 @@
+#ifndef C4_CACHE_H_
+#define C4_CACHE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "c4bitboard.h"
+#include "c4tablebase.h"
+
+namespace c4
+{
+  /**
+   * @brief finished search results by position, shared by every player and session of a process
+   * @details unlike C4TTable, which holds the inner nodes of running searches, an entry is the answer
+   * a whole search gave, so a position any session already played costs one lookup,
+   * mirrored positions share an entry, entries are told apart by a `level` (depth, driver) and a
+   * `tag` (weights, network), the cache is split in shards of a fixed number of slots, each behind
+   * its own lock, a full shard evicts by CLOCK, entries found since the hand last passed survive
+   * @code .cpp
+   * auto cache = std::make_shared<C4MoveCache>(16);
+   * ai.set_move_cache(cache);
+   * //...
+   * BGLOG_INFO("cache", "hit rate {}", cache->stats().hit_rate());
+   * @endcode
+   */
+  class C4MoveCache
+  {
+  public:
+    struct Entry
+    {
+      int column{-1};
+      int score{0}; //for the side to move
+      int depth{0};
+    };
+
+    struct Stats
+    {
+      std::uint64_t hits{0};
+      std::uint64_t misses{0};
+      std::uint64_t inserts{0};
+      std::uint64_t evictions{0};
+      std::size_t size{0};     //entries held
+      std::size_t capacity{0}; //entries the memory cap allows
+
+      inline double hit_rate() const noexcept { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+    };
+
+    /**
+     * @param megabytes memory cap, slots and index included
+     * @param shards rounded up to a power of two, more shards mean less lock contention
+     */
+    explicit C4MoveCache(std::size_t megabytes = 16, std::size_t shards = 16)
+    {
+      std::size_t n = 1;
+      while (n < shards)
+        n *= 2;
+      _bits = 0;
+      while ((std::size_t{1} << _bits) < n)
+        ++_bits;
+
+      const std::size_t per = std::max<std::size_t>(16, (megabytes << 20) / (n * kBytesPerEntry));
+      _shards.reset(new Shard[n]);
+      _count = n;
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        _shards[i].slots.resize(per);
+        _shards[i].index.reserve(per);
+      }
+    }
+
+    C4MoveCache(const C4MoveCache &) = delete;
+    C4MoveCache &operator=(const C4MoveCache &) = delete;
+
+    //-----------------------GETTERS-------------------------
+
+    inline std::size_t capacity() const noexcept { return _count * _shards[0].slots.size(); }
+
+    Stats stats() const
+    {
+      Stats s;
+      for (std::size_t i = 0; i < _count; ++i)
+      {
+        const Shard &shard = _shards[i];
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        s.hits += shard.hits;
+        s.misses += shard.misses;
+        s.inserts += shard.inserts;
+        s.evictions += shard.evictions;
+        s.size += shard.used;
+      }
+      s.capacity = capacity();
+      return s;
+    }
+
+    //-----------------------FUNCTIONS-----------------------
+
+    /**
+     * @param own stones of the side to move
+     * @param mask all stones
+     * @param e [out] the column as seen from the position asked about
+     * @return true | false if no search of this level and tag finished the position
+     */
+    bool Find(bitboard::bits_t own, bitboard::bits_t mask, std::uint32_t level, std::uint64_t tag, Entry &e)
+    {
+      bool mirrored;
+      const std::uint64_t key = _Canonical(own, mask, mirrored), h = _Hash(key, level, tag);
+      Shard &s = _shards[_ShardOf(h)];
+      {
+        std::lock_guard<std::mutex> lock{s.mutex};
+        const auto it = s.index.find(h);
+        if (it == s.index.end() || !s.slots[it->second].Is(key, level, tag))
+        {
+          ++s.misses;
+          return false;
+        }
+        Slot &slot = s.slots[it->second];
+        slot.referenced = true;
+        e = slot.entry;
+        ++s.hits;
+      }
+      if (mirrored && e.column >= 0)
+        e.column = bitboard::kCols - 1 - e.column;
+      return true;
+    }
+
+    //keeps `e` for the position, replacing what the same level and tag stored before
+    void Insert(bitboard::bits_t own, bitboard::bits_t mask, std::uint32_t level, std::uint64_t tag, Entry e)
+    {
+      bool mirrored;
+      const std::uint64_t key = _Canonical(own, mask, mirrored), h = _Hash(key, level, tag);
+      if (mirrored && e.column >= 0)
+        e.column = bitboard::kCols - 1 - e.column;
+
+      Shard &s = _shards[_ShardOf(h)];
+      std::lock_guard<std::mutex> lock{s.mutex};
+      ++s.inserts;
+      const auto it = s.index.find(h);
+      if (it != s.index.end())
+      {
+        s.slots[it->second] = {h, key, tag, level, e, true};
+        return;
+      }
+
+      std::size_t i;
+      if (s.used < s.slots.size())
+        i = s.used++;
+      else
+      {
+        //CLOCK, a second chance for every entry found since the last pass
+        while (s.slots[s.hand].referenced)
+        {
+          s.slots[s.hand].referenced = false;
+          s.hand = (s.hand + 1) % s.slots.size();
+        }
+        i = s.hand;
+        s.hand = (s.hand + 1) % s.slots.size();
+        s.index.erase(s.slots[i].hash);
+        ++s.evictions;
+      }
+      s.slots[i] = {h, key, tag, level, e, false};
+      s.index.emplace(h, std::uint32_t(i));
+    }
+
+    void Clear()
+    {
+      for (std::size_t i = 0; i < _count; ++i)
+      {
+        Shard &s = _shards[i];
+        std::lock_guard<std::mutex> lock{s.mutex};
+        s.index.clear();
+        s.used = s.hand = 0;
+        s.hits = s.misses = s.inserts = s.evictions = 0;
+      }
+    }
+
+  private:
+    struct Slot
+    {
+      std::uint64_t hash{0};
+      std::uint64_t key{0}; //canonical bitboard::Key
+      std::uint64_t tag{0};
+      std::uint32_t level{0};
+      Entry entry;
+      bool referenced{false}; //found since the clock hand last passed
+
+      inline bool Is(std::uint64_t k, std::uint32_t l, std::uint64_t t) const noexcept { return key == k && level == l && tag == t; }
+    };
+
+    struct Shard
+    {
+      mutable std::mutex mutex;
+      std::vector<Slot> slots;
+      std::unordered_map<std::uint64_t, std::uint32_t> index; //hash to slot
+      std::size_t used{0};
+      std::size_t hand{0};
+      std::uint64_t hits{0}, misses{0}, inserts{0}, evictions{0};
+    };
+
+    static constexpr std::size_t kBytesPerEntry = sizeof(Slot) + 40; //index node and bucket included
+
+    std::unique_ptr<Shard[]> _shards;
+    std::size_t _count{0};
+    int _bits{0};
+
+    //the smaller key of the position and its mirror image
+    static inline std::uint64_t _Canonical(bitboard::bits_t own, bitboard::bits_t mask, bool &mirrored) noexcept
+    {
+      const std::uint64_t key = bitboard::Key(own, mask);
+      const std::uint64_t other = bitboard::Key(bitboard::Mirror(own), bitboard::Mirror(mask));
+      mirrored = other < key;
+      return mirrored ? other : key;
+    }
+
+    static inline std::uint64_t _Hash(std::uint64_t key, std::uint32_t level, std::uint64_t tag) noexcept
+    {
+      return C4Tablebase::Hash(key ^ C4Tablebase::Hash(tag * 0x9e3779b97f4a7c15ull + level));
+    }
+
+    inline std::size_t _ShardOf(std::uint64_t h) const noexcept { return _bits ? std::size_t(h >> (64 - _bits)) : 0; }
+  };
+} // namespace c4
+
+#endif //C4_CACHE_H_
@@ -0,0 +1,140 @@
+#ifndef C4_CLIENT_H_
+#define C4_CLIENT_H_
+
+#if defined(__linux__)
+
+#include <cstring>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "c4wire.h"
+
+namespace c4
+{
+  /**
+   * @brief blocking client of C4Server, one connection carrying any number of sessions
+   * @details meant for tests and load tools, Send() can pipeline frames for many
+   * sessions before reading the answers with Receive()
+   * @code .cpp
+   * C4Client c;
+   * if (c.Connect("/tmp/c4.sock"))
+   * {
+   *   auto started = c.Call({wire::op::Enum::NEW, 6, 0, 0});
+   *   auto reply = c.Call({wire::op::Enum::MOVE, 3, 0, started.session});
+   * }
+   * @endcode
+   */
+  class C4Client
+  {
+  public:
+    C4Client() = default;
+    C4Client(const C4Client &) = delete;
+    C4Client &operator=(const C4Client &) = delete;
+    virtual ~C4Client() { Close(); }
+
+    inline bool IsOpen() const noexcept { return _fd >= 0; }
+
+    //connects to a Unix socket path
+    bool Connect(const std::string &unix_path)
+    {
+      Close();
+      sockaddr_un addr{};
+      if (unix_path.size() >= sizeof(addr.sun_path))
+        return false;
+      addr.sun_family = AF_UNIX;
+      std::memcpy(addr.sun_path, unix_path.c_str(), unix_path.size());
+
+      _fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      return _Done(_fd >= 0 && ::connect(_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+    }
+
+    //connects to host:port over TCP
+    bool Connect(const std::string &host, std::uint16_t port)
+    {
+      Close();
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(port);
+      if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+        return false;
+
+      _fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      const int one = 1;
+      return _Done(_fd >= 0 && ::connect(_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0 &&
+                   ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == 0);
+    }
+
+    void Close() noexcept
+    {
+      if (_fd >= 0)
+        ::close(_fd);
+      _fd = -1;
+    }
+
+    bool Send(const wire::Frame &f)
+    {
+      unsigned char buf[wire::kFrame];
+      wire::Encode(f, buf);
+      return _Io(buf, false);
+    }
+
+    /**
+     * @brief next frame from the server
+     * @return false if the connection is gone
+     */
+    bool Receive(wire::Frame &f)
+    {
+      unsigned char buf[wire::kFrame];
+      if (!_Io(buf, true))
+        return false;
+      f = wire::Decode(buf);
+      return true;
+    }
+
+    /**
+     * @brief sends one frame and waits for the answer, do not mix with pipelined Send
+     * @return the answer | op ERROR with arg 0 if the connection is gone
+     */
+    wire::Frame Call(const wire::Frame &f)
+    {
+      wire::Frame reply{wire::op::Enum::ERROR, 0, 0, f.session};
+      if (!Send(f) || !Receive(reply))
+        reply = {wire::op::Enum::ERROR, 0, 0, f.session};
+      return reply;
+    }
+
+  private:
+    int _fd{-1};
+
+    inline bool _Done(bool ok) noexcept
+    {
+      if (!ok)
+        Close();
+      return ok;
+    }
+
+    //whole frame or nothing
+    bool _Io(unsigned char *buf, bool in)
+    {
+      for (std::size_t done = 0; done < wire::kFrame;)
+      {
+        const ssize_t n = in ? ::recv(_fd, buf + done, wire::kFrame - done, 0)
+                             : ::send(_fd, buf + done, wire::kFrame - done, MSG_NOSIGNAL);
+        if (n <= 0)
+          return _Done(false);
+        done += std::size_t(n);
+      }
+      return true;
+    }
+  };
+} // namespace c4
+
+#endif //__linux__
+
+#endif //C4_CLIENT_H_
@@ -0,0 +1,165 @@
+#ifndef C4_EVAL_H_
+#define C4_EVAL_H_
+
+#include <string>
+#include <fstream>
+#include <sstream>
+
+#include "c4bitboard.h"
+#include "c4batch.h"
+
+namespace c4
+{
+  /**
+   * @brief feature weights of C4Evaluator
+   * @details stored as text, one `name value` pair per line, `#` starts a comment
+   * @code .txt
+   * window2 2
+   * window3 9
+   * threat 8
+   * center 3
+   * parity 4
+   * @endcode
+   */
+  struct C4Weights
+  {
+    int window2{2}; //line of four holding 2 own stones and 2 empty cells
+    int window3{9}; //line of four holding 3 own stones and 1 empty cell
+    int threat{8};  //empty cell completing an open three
+    int center{3};  //stone in the center column
+    int parity{4};  //threat on a row of the owner's parity (odd for 1st player, even for 2nd)
+
+    //the subset scored by the SIMD batch kernels
+    inline C4BatchWeights batch() const noexcept { return {threat, center, parity}; }
+
+    /**
+     * @brief reads weights from a file, unknown names and missing ones are left untouched
+     * @param path
+     * @return true | false if the file could not be read or a line is malformed
+     */
+    bool Load(const std::string &path)
+    {
+      std::ifstream in{path};
+      if (!in)
+        return false;
+
+      std::string line;
+      while (std::getline(in, line))
+      {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words{line};
+        std::string name;
+        int value;
+        if (!(words >> name))
+          continue; //blank line
+        if (!(words >> value))
+          return false;
+
+        if (int *w = _Find(name))
+          *w = value;
+      }
+      return true;
+    }
+
+    /**
+     * @brief writes weights in the format read by Load
+     * @param path
+     * @return true | false
+     */
+    bool Save(const std::string &path) const
+    {
+      std::ofstream out{path};
+      out << "window2 " << window2 << '\n'
+          << "window3 " << window3 << '\n'
+          << "threat " << threat << '\n'
+          << "center " << center << '\n'
+          << "parity " << parity << '\n';
+      return bool(out);
+    }
+
+  private:
+    int *_Find(const std::string &name) noexcept
+    {
+      if (name == "window2")
+        return &window2;
+      if (name == "window3")
+        return &window3;
+      if (name == "threat")
+        return &threat;
+      if (name == "center")
+        return &center;
+      if (name == "parity")
+        return &parity;
+      return nullptr;
+    }
+  };
+
+  /**
+   * @brief heuristic score of non terminal positions, branch free bitboard arithmetic only
+   */
+  class C4Evaluator
+  {
+  public:
+    C4Evaluator() = default;
+    explicit C4Evaluator(const C4Weights &weights) : _weights{weights} {}
+
+    inline const auto &weights() const noexcept { return _weights; }
+    inline void set_weights(const C4Weights &weights) noexcept { _weights = weights; }
+
+    /**
+     * @brief score from the side to move's point of view, positive is good for `own`
+     *
+     * @param own stones of the side to move
+     * @param opp stones of the other side
+     * @return int
+     */
+    int Evaluate(bits_t own, bits_t opp) const noexcept
+    {
+      using namespace bitboard;
+
+      const bits_t mask = own | opp;
+      const bits_t empty = kBoard & ~mask;
+
+      int w2 = 0, w3 = 0;
+      for (int s : {1, kStride, kRows, kRows + 2})
+      {
+        w2 += _Windows(own, empty, s, false) - _Windows(opp, empty, s, false);
+        w3 += _Windows(own, empty, s, true) - _Windows(opp, empty, s, true);
+      }
+
+      return _weights.window2 * w2 + _weights.window3 * w3 + batch::Scalar(own, opp, _weights.batch());
+    }
+
+    //EvaluateBatch with these weights
+    inline void Evaluate(const C4PositionBatch &positions, std::vector<int> &scores) const
+    {
+      EvaluateBatch(positions, scores, _weights.batch());
+    }
+
+  private:
+    /**
+     * @brief number of lines of four along shift `s` holding only `stones` and empty cells
+     * @param three count lines with 3 stones, otherwise lines with 2
+     */
+    static int _Windows(bits_t stones, bits_t empty, int s, bool three) noexcept
+    {
+      const bits_t free = stones | empty;
+      const bits_t inside = free & (free >> s) & (free >> (2 * s)) & (free >> (3 * s)); //window start bits
+
+      //bit sliced sum of the 4 cells of every window
+      const bits_t a0 = stones, a1 = stones >> s, a2 = stones >> (2 * s), a3 = stones >> (3 * s);
+      const bits_t s1 = a0 ^ a1, c1 = a0 & a1;
+      const bits_t s2 = a2 ^ a3, c2 = a2 & a3;
+      const bits_t bit0 = s1 ^ s2, carry = s1 & s2;
+      const bits_t bit1 = c1 ^ c2 ^ carry;
+      const bits_t bit2 = (c1 & c2) | ((c1 ^ c2) & carry);
+
+      return bitboard::Count(inside & bit1 & ~bit2 & (three ? bit0 : ~bit0));
+    }
+
+  private:
+    C4Weights _weights;
+  };
+} // namespace c4
+
+#endif //C4_EVAL_H_
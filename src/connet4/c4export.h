@@ -0,0 +1,426 @@
+#ifndef C4_EXPORT_H_
+#define C4_EXPORT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../boardgame/bglog.h"
+#include "../boardgame/bgmmap.h"
+#include "../boardgame/bgpool.h"
+#include "c4bitboard.h"
+#include "c4game.h"
+#include "c4ai.h"
+#include "c4input.h"
+#include "c4tablebase.h"
+
+namespace c4
+{
+  /**
+   * @brief one training position, fixed layout, everything from the side to move's view
+   */
+  struct C4Record
+  {
+    std::uint64_t own;  //stones of the side to move
+    std::uint64_t mask; //all stones
+    std::int32_t score; //search score, C4AI scale, 0 if not searched
+    std::uint8_t ply;   //stones played
+    std::uint8_t side;  //seat to move
+    std::int8_t result; //final result, 1 won, 0 draw, -1 lost
+    std::int8_t best;   //column searched or played, -1 if none
+  };
+
+  static_assert(sizeof(C4Record) == 24, "C4Record layout is part of the file format");
+
+  /**
+   * @brief header of every shard file, records follow it back to back
+   */
+  struct C4ExportHeader
+  {
+    static constexpr char kMagic[4] = {'C', '4', 'T', 'D'};
+    static constexpr std::uint32_t kVersion = 1;
+
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint32_t rows;
+    std::uint32_t cols;
+    std::uint32_t shard; //index of this file
+    std::uint64_t count; //records in this file
+  };
+
+  static_assert(sizeof(C4ExportHeader) % alignof(C4Record) == 0, "records must stay aligned in a mapped file");
+
+  /**
+   * @brief streams records to `shards` files, each position once
+   * @details a position goes to the shard picked by its key, so duplicates are found across
+   * every writer thread without a global lock, each shard buffers `chunk` records per fwrite
+   * @code .cpp
+   * C4Exporter out{{"data/selfplay", 8}};
+   * C4SelfPlay(out, {1000});
+   * out.Close();
+   * @endcode
+   */
+  class C4Exporter
+  {
+  public:
+    struct Options
+    {
+      std::string prefix{"c4data"};            //files are prefix-00000.c4td, prefix-00001.c4td, ...
+      std::size_t shards{4};                   //files and locks
+      std::size_t chunk{std::size_t{1} << 14}; //records buffered per shard
+      bool dedup{true};                        //drop positions seen before, the first record wins
+    };
+
+    explicit C4Exporter(const Options &options) : _o{options}
+    {
+      _o.shards = std::max<std::size_t>(1, _o.shards);
+      _o.chunk = std::max<std::size_t>(1, _o.chunk);
+      for (std::size_t i = 0; i < _o.shards; ++i)
+      {
+        auto s = std::make_unique<Shard>();
+        s->file = std::fopen(Path(i).c_str(), "wb");
+        if (!s->file)
+          BGLOG_ERROR("C4Exporter", "cannot write shard {}", i);
+        else
+          _WriteHeader(*s, i);
+        s->buffer.reserve(_o.chunk);
+        _shards.push_back(std::move(s));
+      }
+    }
+
+    C4Exporter(const C4Exporter &) = delete;
+    C4Exporter &operator=(const C4Exporter &) = delete;
+
+    ~C4Exporter() { Close(); }
+
+    //-----------------------GETTERS-------------------------
+
+    inline const auto &options() const noexcept { return _o; }
+    inline std::string Path(std::size_t shard) const
+    {
+      char name[16];
+      std::snprintf(name, sizeof(name), "-%05zu.c4td", shard);
+      return _o.prefix + name;
+    }
+
+    //records accepted so far, buffered ones included
+    std::uint64_t written() const
+    {
+      std::uint64_t n = 0;
+      for (const auto &s : _shards)
+      {
+        std::lock_guard<std::mutex> lock{s->mutex};
+        n += s->count;
+      }
+      return n;
+    }
+
+    //records dropped as duplicates
+    std::uint64_t duplicates() const
+    {
+      std::uint64_t n = 0;
+      for (const auto &s : _shards)
+      {
+        std::lock_guard<std::mutex> lock{s->mutex};
+        n += s->duplicates;
+      }
+      return n;
+    }
+
+    //-----------------------FUNCTIONS-----------------------
+
+    /**
+     * @brief queues a record, thread safe
+     * @return true | false if it was a duplicate or its shard cannot be written
+     */
+    bool Add(const C4Record &r)
+    {
+      const std::uint64_t key = bitboard::Key(r.own, r.mask);
+      Shard &s = *_shards[C4Tablebase::Hash(key) % _shards.size()];
+
+      std::lock_guard<std::mutex> lock{s.mutex};
+      if (!s.file)
+        return false;
+      if (_o.dedup && !s.keys.insert(key).second)
+      {
+        ++s.duplicates;
+        return false;
+      }
+      s.buffer.push_back(r);
+      ++s.count;
+      if (s.buffer.size() >= _o.chunk)
+        _Flush(s);
+      return true;
+    }
+
+    //queues n records, returns how many were new
+    std::size_t Add(const C4Record *r, std::size_t n)
+    {
+      std::size_t added = 0;
+      for (std::size_t i = 0; i < n; ++i)
+        added += Add(r[i]);
+      return added;
+    }
+
+    /**
+     * @brief writes what is buffered and the final counts, closes every shard
+     * @return true | false on an I/O error
+     */
+    bool Close()
+    {
+      bool ok = true;
+      for (std::size_t i = 0; i < _shards.size(); ++i)
+      {
+        Shard &s = *_shards[i];
+        std::lock_guard<std::mutex> lock{s.mutex};
+        if (!s.file)
+          continue;
+        _Flush(s);
+        ok &= s.ok && std::fseek(s.file, 0, SEEK_SET) == 0;
+        ok &= _WriteHeader(s, i);
+        ok &= std::fclose(s.file) == 0;
+        s.file = nullptr;
+        std::unordered_set<std::uint64_t>{}.swap(s.keys);
+      }
+      return ok;
+    }
+
+  private:
+    struct Shard
+    {
+      mutable std::mutex mutex;
+      std::FILE *file{nullptr};
+      std::vector<C4Record> buffer;
+      std::unordered_set<std::uint64_t> keys;
+      std::uint64_t count{0};
+      std::uint64_t duplicates{0};
+      bool ok{true};
+    };
+
+    Options _o;
+    std::vector<std::unique_ptr<Shard>> _shards;
+
+    bool _WriteHeader(Shard &s, std::size_t index)
+    {
+      C4ExportHeader h{};
+      std::memcpy(h.magic, C4ExportHeader::kMagic, 4);
+      h.version = C4ExportHeader::kVersion;
+      h.record_size = sizeof(C4Record);
+      h.rows = bitboard::kRows;
+      h.cols = bitboard::kCols;
+      h.shard = std::uint32_t(index);
+      h.count = s.count;
+      return std::fwrite(&h, sizeof(h), 1, s.file) == 1;
+    }
+
+    inline void _Flush(Shard &s)
+    {
+      if (s.buffer.empty())
+        return;
+      s.ok &= std::fwrite(s.buffer.data(), sizeof(C4Record), s.buffer.size(), s.file) == s.buffer.size();
+      s.buffer.clear();
+    }
+  };
+
+  /**
+   * @brief collects the positions of one game, results are known only at the end
+   * @code .cpp
+   * C4GameRecorder rec;
+   * while (game.state() == bg::game::Enum::NOTOVER)
+   * {
+   *   int score;
+   *   const int col = ai.BestColumn(game, nullptr, &score);
+   *   rec.Record(game, score, col);
+   *   game.Play(new C4Move(game.AvailableRow(col), col, piece));
+   * }
+   * rec.Finish(game, exporter);
+   * @endcode
+   */
+  class C4GameRecorder
+  {
+  public:
+    inline auto size() const noexcept { return _records.size(); }
+    inline void clear() noexcept { _records.clear(); }
+
+    //position before the side to move plays `best`
+    inline void Record(const C4Game &game, int score, int best)
+    {
+      _records.push_back({game.own(), game.mask(), std::int32_t(score), std::uint8_t(game.ply()),
+                          std::uint8_t(game.turning_player()), 0, std::int8_t(best)});
+    }
+
+    /**
+     * @brief sets the results from the finished game and hands the records over
+     * @return std::size_t records added, 0 if the game is not over
+     */
+    std::size_t Finish(const C4Game &game, C4Exporter &out)
+    {
+      std::size_t added = 0;
+      if (game.state() != bg::game::Enum::NOTOVER)
+      {
+        const bool drawn = game.state() == bg::game::Enum::DRAW;
+        for (auto &r : _records)
+          r.result = drawn ? 0 : r.side == game.winner() ? 1 : -1;
+        added = out.Add(_records.data(), _records.size());
+      }
+      _records.clear();
+      return added;
+    }
+
+    /**
+     * @brief records a game from an archive, e.g. a C4ReplaySource, without a C4Game
+     * @details columns are read until Poll fails, the played column is stored as `best`,
+     * games that are not finished or contain an illegal column are dropped
+     * @return std::size_t records added
+     */
+    std::size_t Replay(C4MoveSource &source, C4Exporter &out)
+    {
+      using namespace bitboard;
+
+      _records.clear();
+      bits_t own = 0, mask = 0;
+      int col, result = 0; //from seat 0
+      while (!result && source.Poll(col))
+      {
+        if (col < 0 || col >= kCols || (mask & Column(col)) == Column(col))
+          return _records.clear(), 0;
+
+        const int ply = Count(mask);
+        _records.push_back({own, mask, 0, std::uint8_t(ply), std::uint8_t(ply & 1), 0, std::int8_t(col)});
+
+        own |= (mask + BottomOf(col)) & Column(col);
+        mask |= (mask + BottomOf(col)) & Column(col);
+        if (IsAligned(own))
+          result = ply & 1 ? -1 : 1;
+        else if (Count(mask) == kCells)
+          break;
+        own ^= mask; //the other side moves
+      }
+      if (!result && Count(mask) != kCells)
+        return _records.clear(), 0;
+
+      for (auto &r : _records)
+        r.result = std::int8_t(r.side ? -result : result);
+      const std::size_t added = out.Add(_records.data(), _records.size());
+      _records.clear();
+      return added;
+    }
+
+  private:
+    std::vector<C4Record> _records;
+  };
+
+  /**
+   * @brief self play with the C4AI, every searched position is exported with its score and best column
+   */
+  struct C4SelfPlayOptions
+  {
+    std::size_t games{100};
+    std::size_t level{6};          //search depth of both sides
+    int random_plies{4};           //random opening stones, not exported
+    std::uint64_t seed{1};         //game i is seeded with seed + i
+    bg::ThreadPool *pool{nullptr}; //nullptr for the shared pool
+  };
+
+  /**
+   * @brief plays `games` games on the pool at LOW priority
+   * @return std::size_t records added
+   */
+  inline std::size_t C4SelfPlay(C4Exporter &out, const C4SelfPlayOptions &o = {})
+  {
+    bg::ThreadPool &pool = o.pool ? *o.pool : bg::ThreadPool::Shared();
+    std::vector<std::size_t> added(o.games, 0);
+
+    pool.ParallelFor(o.games, [&](std::size_t i) {
+      const C4AI a{"a", o.level, C4Piece{'A'}}, b{"b", o.level, C4Piece{'B'}};
+      const C4AI *ai[2] = {&a, &b};
+      C4Game game;
+      game.insert(a);
+      game.insert(b);
+
+      std::mt19937_64 rng{o.seed + i};
+      C4GameRecorder rec;
+      while (game.state() == bg::game::Enum::NOTOVER)
+      {
+        const std::size_t turn = game.turning_player();
+        int score = 0, col;
+        if (int(game.ply()) < o.random_plies)
+        {
+          int open[C4Game::kCols], n = 0;
+          for (int c = 0; c < C4Game::kCols; ++c)
+            if (game.AvailableRow(std::size_t(c)) < C4Game::kRows)
+              open[n++] = c;
+          col = open[rng() % std::uint64_t(n)];
+        }
+        else
+        {
+          col = ai[turn]->BestColumn(game, nullptr, &score);
+          rec.Record(game, score, col);
+        }
+        game.Play(new C4Move(game.AvailableRow(std::size_t(col)), col, *(game.players()->at(turn)->pieces().front())));
+      }
+      added[i] = rec.Finish(game, out);
+    }, bg::priority::Enum::LOW);
+
+    std::size_t n = 0;
+    for (const auto a : added)
+      n += a;
+    return n;
+  }
+
+  /**
+   * @brief read only view of one shard file, mapped, records are used in place
+   */
+  class C4ExportFile
+  {
+  public:
+    C4ExportFile() = default;
+    explicit C4ExportFile(const std::string &path) { Open(path); }
+
+    /**
+     * @return true | false if missing, truncated, from another version or for another board
+     */
+    bool Open(const std::string &path)
+    {
+      _records = nullptr;
+      _header = {};
+      if (!_file.Open(path) || _file.size() < sizeof(C4ExportHeader))
+        return false;
+
+      std::memcpy(&_header, _file.data(), sizeof(_header));
+      if (std::memcmp(_header.magic, C4ExportHeader::kMagic, 4) || _header.version != C4ExportHeader::kVersion ||
+          _header.record_size != sizeof(C4Record) || _header.rows != bitboard::kRows || _header.cols != bitboard::kCols ||
+          _file.size() != sizeof(C4ExportHeader) + _header.count * sizeof(C4Record))
+      {
+        BGLOG_WARN("C4ExportFile::Open", "{} is not training data for this build", path);
+        _file.Close();
+        _header = {};
+        return false;
+      }
+
+      _records = reinterpret_cast<const C4Record *>(_file.data() + sizeof(C4ExportHeader));
+      return true;
+    }
+
+    inline bool IsOpen() const noexcept { return _records != nullptr || (_file.IsOpen() && !_header.count); }
+    inline const auto &header() const noexcept { return _header; }
+    inline std::size_t size() const noexcept { return std::size_t(_header.count); }
+    inline const C4Record &operator[](std::size_t i) const noexcept { return _records[i]; }
+    inline const C4Record *begin() const noexcept { return _records; }
+    inline const C4Record *end() const noexcept { return _records + size(); }
+
+  private:
+    bg::MappedFile _file;
+    C4ExportHeader _header{};
+    const C4Record *_records{nullptr};
+  };
+} // namespace c4
+
+#endif //C4_EXPORT_H_
@@ -1,23 +1,67 @@
 #ifndef C4_STATE_
 #define C4_STATE_
 
+#include <array>
+#include <cstdint>
 #include <vector>
+#include <climits>
 
 #include "c4types.h"
+#include "c4bitboard.h"
+#include "c4batch.h"
 
 namespace c4
 {
+  struct C4State;
+  class C4Game;
+
+  /**
+   * @brief told about every stone placed or taken back, e.g. to update an evaluator incrementally
+   * @details `mover` is 0 for the first mover's stones and 1 for the second's
+   */
+  class C4GameListener
+  {
+  public:
+    virtual ~C4GameListener() = default;
+
+    virtual void OnApply(int mover, int row, int col) = 0;
+    virtual void OnUndo(int mover, int row, int col) = 0;
+    //the whole position changed, e.g. restored from a C4State
+    virtual void OnReset(const C4Game &game) = 0;
+  };
 
   class C4Game : public BGame
   {
   public:
     inline static const C4Piece kEmpty{'.'};
-    static const int kRows = 6;
-    static const int kCols = 7;
-    int available_row[kCols];
+    static const int kRows = bitboard::kRows;
+    static const int kCols = bitboard::kCols;
+    int available_row[kCols]{};
 
     C4Game() noexcept : BGame{0, C4Players{0, 2}, C4Board{kRows, kCols}} {}
 
+    //number of stones played
+    inline auto ply() const noexcept { return _ply; }
+    //all stones on the board
+    inline auto mask() const noexcept { return _mask; }
+    //stones of the side to move
+    inline auto own() const noexcept { return _stones[_ply & 1]; }
+    //stones of the side that just moved
+    inline auto opp() const noexcept { return _stones[(_ply + 1) & 1]; }
+    //seat that placed the first stone, the seat to move while the board is empty
+    inline bg::int_t first_seat() const noexcept { return _ply ? _first_seat : bg::int_t(turning_player()); }
+    //stones of a seat
+    inline auto stones(std::size_t seat) const noexcept { return _stones[bg::int_t(seat) == first_seat() ? 0 : 1]; }
+    //seat that placed the last stone, -1 before the first
+    inline auto last_mover() const noexcept { return _last_mover; }
+    //moves Undo can take back
+    inline int undoable() const noexcept { return _ply - _base; }
+    //column of the stone played at `ply`, for ply() - undoable() <= ply < ply()
+    inline int history(int ply) const noexcept { return _history[ply]; }
+
+    //not copied or moved with the game, nullptr to detach
+    inline void set_listener(C4GameListener *listener) noexcept { _listener.ptr = listener; }
+
     size_t NextPlayer(size_t playerid) const override
     {
       return (playerid + 1) % players()->size();
@@ -25,86 +69,142 @@ namespace c4
 
     const std::vector<C4Move *> GetPossibleMoves(size_t playerid) const override
     {
+      _ISSTAT_ bg::stats::Count(bg::stats::Enum::GET_POSSIBLE_MOVES);
+
       std::vector<C4Move *> moves;
       for (auto c = 0; c < kCols; ++c)
-        if (*(at(kRows - 1, c)) == kEmpty)
+        if (available_row[c] < kRows)
           moves.push_back(new C4Move(available_row[c], c, *(players()->at(playerid)->pieces().at(0))));
 
       return moves;
     }
-    bool IsWinningState(size_t playerid) const override { return false; }
+
+    //O(1), reads the flag cached by the last Apply
+    bool IsWinningState(size_t playerid) const override { return _last_won && _last_mover == bg::int_t(playerid); }
+
     bool IsValid(const C4Move &mov, size_t playerid) const override
     {
-      return available_row[mov.col()] >= 0 ? true : false;
+      _ISSTAT_ bg::stats::Count(bg::stats::Enum::IS_VALID);
+
+      if (_last_won || mov.col() < 0 || mov.col() >= kCols)
+        return false;
+      return available_row[mov.col()] < kRows && mov.row() == available_row[mov.col()];
     }
-    bool IsNoMoreMoves() const override { return false; }
+
+    //O(1), every cell is taken
+    bool IsNoMoreMoves() const override { return _ply >= bitboard::kCells; }
+
     bool Apply(const C4Move &mov) override
     {
+      _ISSTAT_ bg::stats::Count(bg::stats::Enum::APPLY);
+
       board()->insert(size_t(mov.row()), size_t(mov.col()), *(mov.piece()));
       available_row[mov.col()]++;
+      if (!_ply)
+        _first_seat = turning_player();
+
+      const auto cell = bitboard::Cell(int(mov.row()), int(mov.col()));
+      _stones[_ply & 1] |= cell;
+      _mask |= cell;
+      _last_won = bitboard::IsAligned(_stones[_ply & 1]);
+      _last_mover = turning_player();
+      _history[_ply] = std::int8_t(mov.col());
+      if (_listener.ptr)
+        _listener.ptr->OnApply(_ply & 1, int(mov.row()), int(mov.col()));
+      ++_ply;
+      return true;
+    }
+
+    /**
+     * @brief takes the last stone back, the game is not over afterwards
+     * @return true | false if there is nothing to undo
+     */
+    bool Undo()
+    {
+      if (_ply <= _base)
+        return false;
+
+      --_ply;
+      const int col = _history[_ply], row = --available_row[col];
+      board()->erase(size_t(row), size_t(col));
+
+      const auto cell = bitboard::Cell(row, col);
+      _stones[_ply & 1] &= ~cell;
+      _mask &= ~cell;
+      _last_won = false; //the game went on after the previous stone
+      _turning_player = _last_mover;
+      _last_mover = _ply ? bg::int_t(NextPlayer(size_t(_last_mover))) : -1;
+      _winner = -1;
+      _set_state(bg::game::Enum::NOTOVER);
+
+      if (_listener.ptr)
+        _listener.ptr->OnUndo(_ply & 1, row, col);
       return true;
     }
+
     C4Game *copy() const override { return new C4Game{*this}; }
     C4Game *move() override { return new C4Game{std::forward<C4Game>(*this)}; }
+
+    //O(1), four in a row through the new stone of `playerid`, whether or not it is that seat's turn
     bool IsWinning(const C4Move &mov, size_t playerid) const override
     {
-      const C4Player *cp = at(playerid);
-      bool isWin = false;
+      _ISSTAT_ bg::stats::Count(bg::stats::Enum::IS_WINNING);
 
-      int r = mov.row();
-      int c = mov.col();
-      if (!(cp->IsPlayerPiece(*(mov.piece()))))
+      if (players()->SeatOf(*(mov.piece())) != bg::int_t(playerid))
         return false;
+      return bitboard::IsAligned(stones(playerid) | bitboard::Cell(int(mov.row()), int(mov.col())));
+    }
 
-      //check vertically, only need to check down
-      if (!isWin)
-      {
-        int down = 0;
-        for (int row = r + 1; row < 6 && cp->IsPlayerPiece(*(board()->at(row, c))); ++row) //moving down
-          ++down;
-        isWin = down >= 3 ? true : false;
-      }
-
-      //check horizontaly
-      if (!isWin)
-      {
-        int right = 0, left = 0;
-        for (int col = c - 1; col >= 0 && cp->IsPlayerPiece(*(board()->at(r, col))); --col) //moving left
-          ++left;
-        for (int col = c + 1; col < 7 && cp->IsPlayerPiece(*(board()->at(r, col))); ++col) //moving right
-          ++right;
-        isWin = (left + right) >= 3 ? true : false;
-      }
-
-      //check forward diagnal e.g //
-      if (!isWin)
-      {
-        int upright = 0, downleft = 0;
-        for (int col = c - 1, row = r + 1; col >= 0 && row < 6 && cp->IsPlayerPiece(*(board()->at(row, col))); --col, ++row) //moving downleft
-          ++downleft;
-        for (int col = c + 1, row = r - 1; col < 7 && row >= 0 && cp->IsPlayerPiece(*(board()->at(row, col))); ++col, --row) //moving upright
-          ++upright;
-        isWin = (downleft + upright) >= 3 ? true : false;
-      }
-
-      /*check backward diagnal e.g \\*/
-
-      if (!isWin)
-      {
-        int upleft = 0, downright = 0;
-        for (int col = c + 1, row = r + 1; col < 7 && row < 6 && cp->IsPlayerPiece(*(board()->at(row, col))); ++col, ++row) //moving downright
-          ++downright;
-        for (int col = c - 1, row = r - 1; col >= 0 && row >= 0 && cp->IsPlayerPiece(*(board()->at(row, col))); --col, --row) //moving upleft
-          ++upleft;
-        isWin = (downright + upleft) >= 3 ? true : false;
-      }
-
-      return isWin;
+    //field read instead of asking every player
+    bool IsWinningStateRecheck() override
+    {
+      if (!_last_won)
+        return false;
+      _set_state(bg::game::Enum::OVER);
+      _winner = _last_mover;
+      return true;
     }
+
     int AvailableRow(const std::size_t col) const
     {
       return available_row[col];
     }
+
+    /**
+     * @brief heuristic score of every column for the side to move, children scored as one batch
+     * @param w feature weights
+     * @return INT_MIN for full columns
+     */
+    std::array<int, kCols> ScoreMoves(const C4BatchWeights &w = {}) const
+    {
+      return ScoreChildren(own(), mask(), w);
+    }
+
+  private:
+    friend struct C4State;
+
+    //pointer that stays with its game when the game is copied or moved
+    struct Listener
+    {
+      C4GameListener *ptr{nullptr};
+
+      Listener() = default;
+      Listener(const Listener &) noexcept {}
+      Listener &operator=(const Listener &) noexcept { return *this; }
+    };
+
+    //position from a compact state, defined in c4state.h
+    inline void _Restore(const C4State &s);
+
+    bitboard::bits_t _mask{0};                //all stones
+    bitboard::bits_t _stones[2]{0, 0};        //stones of the first and second mover
+    int _ply{0};                              //stones played
+    int _base{0};                             //ply the history starts at
+    bool _last_won{false};                    //the last stone made four in a row
+    bg::int_t _last_mover{-1};                //id of the player who placed the last stone
+    bg::int_t _first_seat{0};                 //seat of _stones[0], set by the first Apply
+    std::int8_t _history[bitboard::kCells]{}; //column of every stone, valid from _base to _ply
+    Listener _listener;                       //incremental observer
   };
 } // namespace c4
 
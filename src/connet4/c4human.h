@@ -2,39 +2,49 @@
 #ifndef C4_HUMAN_
 #define C4_HUMAN_
 
+#include <memory>
 #include <string>
-#include <iostream>
 
 #include "c4types.h"
 #include "c4game.h"
+#include "c4input.h"
 
 namespace c4
 {
   class C4Game;
 
+  /**
+   * @brief human player, columns come from a C4MoveSource, std::cin unless told otherwise
+   * @details with a non blocking source SuggestMove returns nullptr until a column arrives,
+   * so MakeMove can be retried from a loop serving other games, unplayable columns are skipped
+   */
   class C4Human : public C4Player
   {
   public:
-    C4Human(std::string name, std::size_t diff_level = 4) : Player(name, diff_level) {}
+    C4Human(std::string name, std::size_t diff_level = 4) : Player(name, diff_level), _source{std::make_shared<C4StreamSource>()} {}
 
-    C4Human(std::string name, std::size_t diff_level = 4, C4Piece p = {'H'}) : Player(name, diff_level, p) {}
+    C4Human(std::string name, std::size_t diff_level = 4, C4Piece p = {'H'}) : Player(name, diff_level, p), _source{std::make_shared<C4StreamSource>()} {}
+
+    C4Human(std::string name, std::size_t diff_level, C4Piece p, std::shared_ptr<C4MoveSource> source)
+        : Player(name, diff_level, p), _source{std::move(source)} {}
+
+    inline const auto &source() const noexcept { return _source; }
+    inline void set_source(std::shared_ptr<C4MoveSource> source) noexcept { _source = std::move(source); }
 
     C4Move *SuggestMove(const BGame &state) const override
     {
       const C4Game *c4state = dynamic_cast<const C4Game *>(&state);
-      if (!c4state)
+      if (!c4state || !_source)
         return nullptr;
 
-      std::size_t col;
-      std::cout << "Please enter your move (1-7)";
-      std::cin >> col;
-      const int row = c4state->AvailableRow(col);
-
-      c4state=nullptr;
-
-      C4Move *mov = new C4Move(static_cast<bg::int_t>(row), static_cast<bg::int_t>(col - 1), *(_pieces.front()));
-
-      return mov;
+      int col;
+      while (_source->Poll(col))
+      {
+        if (col >= 0 && col < C4Game::kCols && c4state->AvailableRow(std::size_t(col)) < C4Game::kRows)
+          return new C4Move(c4state->AvailableRow(std::size_t(col)), col, *(_pieces.front()));
+        BGLOG_WARN("C4Human::SuggestMove", "{} is not a playable column", col + 1);
+      }
+      return nullptr;
     }
 
     C4Human *copy() const override
@@ -45,6 +55,9 @@ namespace c4
     {
       return new C4Human(std::forward<C4Human>(*this));
     }
+
+  protected:
+    std::shared_ptr<C4MoveSource> _source; //shared by copies of the player
   };
 
 } // namespace c4
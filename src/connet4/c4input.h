@@ -0,0 +1,252 @@
+#ifndef C4_INPUT_H_
+#define C4_INPUT_H_
+
+#include <cctype>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace c4
+{
+  /**
+   * @brief where a C4Human gets its columns from, columns are 0 based
+   * @details Poll never waits unless IsBlocking(), so one thread can serve many games,
+   * a column of -1 is input that was not a column at all
+   */
+  class C4MoveSource
+  {
+  public:
+    virtual ~C4MoveSource() = default;
+
+    /**
+     * @brief next column if one is there
+     * @param col [out]
+     * @return true | false if nothing arrived yet or the source is closed
+     */
+    virtual bool Poll(int &col) = 0;
+
+    //no more input will ever come
+    virtual bool IsClosed() const = 0;
+
+    //Poll waits for input, invalid columns are then asked again
+    virtual bool IsBlocking() const { return false; }
+  };
+
+  /**
+   * @brief columns pushed by another thread or by the same loop, e.g. a UI or a load test
+   */
+  class C4QueueSource : public C4MoveSource
+  {
+  public:
+    inline void Push(int col)
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _cols.push_back(col);
+    }
+
+    //no Push will follow
+    inline void Close()
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      _closed = true;
+    }
+
+    bool Poll(int &col) override
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      if (_cols.empty())
+        return false;
+      col = _cols.front();
+      _cols.pop_front();
+      return true;
+    }
+
+    bool IsClosed() const override
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      return _closed && _cols.empty();
+    }
+
+  private:
+    mutable std::mutex _mutex;
+    std::deque<int> _cols;
+    bool _closed{false};
+  };
+
+  /**
+   * @brief 1 based columns typed into a stream, blocking, std::cin by default
+   */
+  class C4StreamSource : public C4MoveSource
+  {
+  public:
+    explicit C4StreamSource(std::istream &in = std::cin, std::string prompt = "Please enter your move (1-7)")
+        : _in{in}, _prompt{std::move(prompt)} {}
+
+    bool Poll(int &col) override
+    {
+      if (!_prompt.empty())
+        std::cout << _prompt;
+
+      int typed;
+      if (_in >> typed)
+      {
+        col = typed - 1;
+        return true;
+      }
+      if (_in.eof())
+        return false;
+
+      //not a number, drop the line
+      _in.clear();
+      _in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+      col = -1;
+      return true;
+    }
+
+    bool IsClosed() const override { return _in.eof() || _in.bad(); }
+    bool IsBlocking() const override { return true; }
+
+  private:
+    std::istream &_in;
+    std::string _prompt;
+  };
+
+  /**
+   * @brief 1 based columns of a recorded game, "4 4 3 5" or "4435"
+   */
+  class C4ReplaySource : public C4MoveSource
+  {
+  public:
+    C4ReplaySource() = default;
+
+    //columns from text
+    static C4ReplaySource FromString(const std::string &text)
+    {
+      C4ReplaySource r;
+      r._Parse(text);
+      return r;
+    }
+
+    //columns from a file, empty if it cannot be read
+    static C4ReplaySource FromFile(const std::string &path)
+    {
+      std::ifstream f{path};
+      std::stringstream text;
+      text << f.rdbuf();
+      return FromString(text.str());
+    }
+
+    inline auto size() const noexcept { return _cols.size(); }
+
+    bool Poll(int &col) override
+    {
+      if (_next >= _cols.size())
+        return false;
+      col = _cols[_next++];
+      return true;
+    }
+
+    bool IsClosed() const override { return _next >= _cols.size(); }
+
+  private:
+    std::vector<int> _cols;
+    std::size_t _next{0};
+
+    //every digit is a column, anything else separates
+    void _Parse(const std::string &text)
+    {
+      for (const char c : text)
+        if (std::isdigit(static_cast<unsigned char>(c)))
+          _cols.push_back(c - '1');
+    }
+  };
+
+#if defined(__linux__)
+  /**
+   * @brief 1 based column digits read without blocking from a socket, pipe or terminal
+   */
+  class C4FdSource : public C4MoveSource
+  {
+  public:
+    /**
+     * @param fd switched to non blocking
+     * @param own close it in the destructor
+     */
+    explicit C4FdSource(int fd, bool own = false) : _fd{fd}, _own{own}
+    {
+      const int flags = ::fcntl(_fd, F_GETFL, 0);
+      if (flags >= 0)
+        ::fcntl(_fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    C4FdSource(const C4FdSource &) = delete;
+    C4FdSource &operator=(const C4FdSource &) = delete;
+
+    ~C4FdSource() override
+    {
+      if (_own && _fd >= 0)
+        ::close(_fd);
+    }
+
+    inline auto fd() const noexcept { return _fd; }
+
+    bool Poll(int &col) override
+    {
+      _Read();
+      while (_at < _buf.size())
+      {
+        const char c = _buf[_at++];
+        if (std::isspace(static_cast<unsigned char>(c)))
+          continue;
+        col = std::isdigit(static_cast<unsigned char>(c)) ? c - '1' : -1;
+        return true;
+      }
+      return false;
+    }
+
+    bool IsClosed() const override { return _eof && _at >= _buf.size(); }
+
+  private:
+    int _fd;
+    bool _own;
+    bool _eof{false};
+    std::string _buf;
+    std::size_t _at{0};
+
+    void _Read()
+    {
+      if (_at >= _buf.size())
+      {
+        _buf.clear();
+        _at = 0;
+      }
+
+      char chunk[256];
+      while (!_eof)
+      {
+        const ssize_t n = ::read(_fd, chunk, sizeof(chunk));
+        if (n > 0)
+          _buf.append(chunk, std::size_t(n));
+        else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+          _eof = true;
+        else
+          break;
+      }
+    }
+  };
+#endif //__linux__
+
+} // namespace c4
+
+#endif //C4_INPUT_H_
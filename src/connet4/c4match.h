@@ -0,0 +1,311 @@
+#ifndef C4_MATCH_H_
+#define C4_MATCH_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../boardgame/bgasync.h"
+#include "../boardgame/bglog.h"
+#include "../boardgame/bgpool.h"
+#include "../boardgame/bgstats.h"
+#include "c4ai.h"
+#include "c4bitboard.h"
+#include "c4game.h"
+#include "c4input.h"
+
+namespace c4
+{
+  /**
+   * @brief one side of a match, everything that changes how the engine plays
+   */
+  struct C4EngineConfig
+  {
+    std::string name{"engine"};
+    std::size_t level{8};                    //search depth, the limit when move_ms is set
+    std::uint64_t move_ms{0};                //time per move, deepening until it runs out, 0 for none
+    driver::Enum driver{driver::Enum::PVS};  //root search
+    C4Weights weights{};                     //horizon scoring
+    std::shared_ptr<const C4Nnue> network{}; //horizon scoring instead of weights if set
+    std::size_t tt_megabytes{4};             //table of each game, 0 for none
+
+    //the player, with a table of its own
+    C4AI Make(C4Piece piece) const
+    {
+      C4AI ai{name, level, piece, weights};
+      ai.set_network(network);
+      ai.set_driver(driver, tt_megabytes);
+      return ai;
+    }
+  };
+
+  namespace sprt
+  {
+    enum class Enum
+    {
+      CONTINUE, //neither bound reached yet
+      H0,       //the first engine is not stronger by elo1, elo0 holds
+      H1,       //the first engine is stronger by elo1
+    };
+
+    inline const char *ToString(Enum value) noexcept
+    {
+      switch (value)
+      {
+      case Enum::CONTINUE:
+        return "CONTINUE";
+      case Enum::H0:
+        return "H0";
+      case Enum::H1:
+        return "H1";
+      }
+      return "UNKNOWN";
+    }
+
+    //expected score of an elo difference
+    inline double Score(double elo) noexcept { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+    //elo difference of an expected score in (0, 1)
+    inline double Elo(double score) noexcept { return -400.0 * std::log10(1.0 / score - 1.0); }
+
+    /**
+     * @brief log likelihood ratio of elo1 against elo0 for a win, draw, loss count
+     * @details the generalized SPRT with the normal approximation of the trinomial, as fishtest
+     * and cutechess use it, the variance is the one measured by the games
+     */
+    inline double Llr(std::uint64_t wins, std::uint64_t draws, std::uint64_t losses, double elo0, double elo1) noexcept
+    {
+      const double n = double(wins + draws + losses);
+      if (!n)
+        return 0.0;
+      const double m = (double(wins) + 0.5 * double(draws)) / n;
+      const double var = (double(wins) * (1 - m) * (1 - m) + double(draws) * (0.5 - m) * (0.5 - m) +
+                          double(losses) * m * m) /
+                         n;
+      if (var <= 0)
+        return 0.0; //every game had the same result, no variance measured yet
+      const double s0 = Score(elo0), s1 = Score(elo1);
+      return n * (s1 - s0) * (2 * m - s0 - s1) / (2 * var);
+    }
+  } // namespace sprt
+
+  /**
+   * @brief starting positions for matches, 1 based columns as C4ReplaySource reads them
+   * @details every sequence of `plies` stones is searched to `level`, positions scored within
+   * `margin` for the side to move are kept, mirror images once, shuffled by `seed`
+   */
+  inline std::vector<std::string> C4BalancedOpenings(int plies = 4, std::size_t level = 6, int margin = 12,
+                                                     std::uint64_t seed = 1)
+  {
+    using namespace bitboard;
+
+    std::vector<std::string> lines{""};
+    std::vector<std::pair<bits_t, bits_t>> positions{{0, 0}};
+    for (int p = 0; p < plies; ++p)
+    {
+      std::vector<std::string> next_lines;
+      std::vector<std::pair<bits_t, bits_t>> next;
+      std::unordered_set<std::uint64_t> seen;
+      for (std::size_t i = 0; i < lines.size(); ++i)
+      {
+        const bits_t own = positions[i].first, mask = positions[i].second;
+        for (int c = 0; c < kCols; ++c)
+        {
+          const bits_t cell = Possible(mask) & Column(c);
+          if (!cell || IsAligned(own | cell))
+            continue;
+          //the side to move changes, so does whose stones `own` holds
+          const bits_t child = own ^ mask, child_mask = mask | cell;
+          const std::uint64_t key = std::min(Key(child, child_mask), Key(Mirror(child), Mirror(child_mask)));
+          if (!seen.insert(key).second)
+            continue;
+          next_lines.push_back(lines[i] + char('1' + c));
+          next.emplace_back(child, child_mask);
+        }
+      }
+      lines.swap(next_lines);
+      positions.swap(next);
+    }
+
+    std::vector<char> keep(lines.size(), 0);
+    bg::ThreadPool::Shared().ParallelFor(lines.size(), [&](std::size_t i) {
+      const C4AI judge{"judge", level};
+      const int score = judge.Search(positions[i].first, positions[i].second).score;
+      keep[i] = std::abs(score) <= margin;
+    }, bg::priority::Enum::LOW);
+
+    std::vector<std::string> openings;
+    for (std::size_t i = 0; i < lines.size(); ++i)
+      if (keep[i])
+        openings.push_back(lines[i]);
+    std::shuffle(openings.begin(), openings.end(), std::mt19937_64{seed});
+    return openings;
+  }
+
+  /**
+   * @brief engine against engine, pairs of games on one opening with colours swapped, until the SPRT decides
+   * @details pairs run in parallel on the pool, every finished pair updates the count and the
+   * log likelihood ratio, once it leaves [lower, upper] no new pair starts, so a clear result
+   * costs a fraction of max_pairs, pairs already running are finished and counted
+   * @code .cpp
+   * C4Match::Options o;
+   * o.first.level = 9;
+   * o.second.level = 8;
+   * const C4Match::Result r = C4Match{o}.Run();
+   * BGLOG_INFO("match", "{} elo {} +- {}", sprt::ToString(r.decision), r.elo, r.elo_error);
+   * @endcode
+   */
+  class C4Match
+  {
+  public:
+    struct Options
+    {
+      C4EngineConfig first{};            //the engine under test, results are from its side
+      C4EngineConfig second{};           //the baseline
+      std::vector<std::string> openings; //1 based columns, empty for C4BalancedOpenings()
+      std::size_t max_pairs{5000};       //stops here if the SPRT has not decided
+      double elo0{0.0};                  //H0, first is not stronger than this
+      double elo1{5.0};                  //H1, first is stronger by this
+      double alpha{0.05};                //chance of accepting H1 when H0 holds
+      double beta{0.05};                 //chance of accepting H0 when H1 holds
+      bool sprt{true};                   //false to play max_pairs
+      int report_pairs{100};             //log the standing this often, 0 never
+      bg::ThreadPool *pool{nullptr};     //nullptr for the shared pool
+    };
+
+    struct Result
+    {
+      std::uint64_t wins{0}, draws{0}, losses{0}; //of the first engine
+      std::size_t pairs{0};
+      double llr{0}, lower{0}, upper{0};
+      sprt::Enum decision{sprt::Enum::CONTINUE};
+      double elo{0};       //of the first engine over the second
+      double elo_error{0}; //95% interval half width
+      std::uint64_t ms{0};
+
+      inline std::uint64_t games() const noexcept { return wins + draws + losses; }
+      inline double score() const noexcept { return games() ? (double(wins) + 0.5 * double(draws)) / double(games()) : 0.5; }
+    };
+
+    explicit C4Match(const Options &options) : _o{options}
+    {
+      if (_o.openings.empty())
+        _o.openings = C4BalancedOpenings();
+    }
+
+    inline const auto &options() const noexcept { return _o; }
+
+    /**
+     * @brief plays until the SPRT decides or max_pairs are played
+     */
+    Result Run()
+    {
+      bg::ThreadPool &pool = _o.pool ? *_o.pool : bg::ThreadPool::Shared();
+      const std::uint64_t start = bg::stats::Now();
+
+      Result r;
+      r.lower = std::log(_o.beta / (1 - _o.alpha));
+      r.upper = std::log((1 - _o.beta) / _o.alpha);
+
+      std::mutex mutex;
+      std::atomic<std::size_t> next{0};
+      std::atomic<bool> decided{false};
+
+      //one puller per worker, pairs are taken in order until the test decides
+      pool.ParallelFor(std::max<std::size_t>(1, pool.size()), [&](std::size_t) {
+        for (;;)
+        {
+          const std::size_t pair = next.fetch_add(1);
+          if (pair >= _o.max_pairs || decided.load(std::memory_order_relaxed))
+            return;
+
+          const std::string &opening = _o.openings[pair % _o.openings.size()];
+          const int a = Play(opening, true), b = Play(opening, false);
+
+          std::lock_guard<std::mutex> lock{mutex};
+          for (const int result : {a, b})
+            ++(result > 0 ? r.wins : result < 0 ? r.losses : r.draws);
+          ++r.pairs;
+          r.llr = sprt::Llr(r.wins, r.draws, r.losses, _o.elo0, _o.elo1);
+          if (_o.sprt && r.decision == sprt::Enum::CONTINUE && (r.llr <= r.lower || r.llr >= r.upper))
+          {
+            r.decision = r.llr >= r.upper ? sprt::Enum::H1 : sprt::Enum::H0;
+            decided = true;
+          }
+          if (_o.report_pairs > 0 && r.pairs % std::size_t(_o.report_pairs) == 0)
+            BGLOG_INFO("C4Match", "pairs {} w {} d {} l {} llr {}", r.pairs, r.wins, r.draws, r.losses, r.llr);
+        }
+      }, bg::priority::Enum::LOW);
+
+      //score and interval from the games, clamped off 0 and 1
+      const double n = double(r.games());
+      if (n > 0)
+      {
+        const double m = r.score();
+        const double var = (double(r.wins) * (1 - m) * (1 - m) + double(r.draws) * (0.5 - m) * (0.5 - m) +
+                            double(r.losses) * m * m) /
+                           n;
+        const double half = 1.96 * std::sqrt(var / n);
+        auto elo = [](double s) { return sprt::Elo(std::min(0.999, std::max(0.001, s))); };
+        r.elo = elo(m);
+        r.elo_error = (elo(m + half) - elo(m - half)) / 2;
+      }
+      r.ms = (bg::stats::Now() - start) / 1000000;
+      return r;
+    }
+
+    /**
+     * @brief one game from `opening`
+     * @param first_starts true if the first engine plays the first stone of the opening
+     * @return 1 the first engine won, 0 draw, -1 it lost
+     */
+    int Play(const std::string &opening, bool first_starts) const
+    {
+      const C4EngineConfig *config[2] = {first_starts ? &_o.first : &_o.second, first_starts ? &_o.second : &_o.first};
+      const C4AI ai[2] = {config[0]->Make(C4Piece{'A'}), config[1]->Make(C4Piece{'B'})};
+      C4Game game;
+      game.insert(ai[0]);
+      game.insert(ai[1]);
+
+      auto replay = C4ReplaySource::FromString(opening);
+      int col;
+      while (game.state() == bg::game::Enum::NOTOVER && replay.Poll(col))
+        _Play(game, col);
+
+      while (game.state() == bg::game::Enum::NOTOVER)
+      {
+        const std::size_t turn = game.turning_player();
+        if (config[turn]->move_ms)
+        {
+          bg::MoveSearch<char> search{bg::SearchOptions::Within(config[turn]->move_ms)};
+          col = ai[turn].Search(game, &search).column;
+        }
+        else
+          col = ai[turn].Search(game).column;
+        _Play(game, col);
+      }
+
+      if (game.state() != bg::game::Enum::OVER)
+        return 0;
+      const int first_seat = first_starts ? 0 : 1;
+      return int(game.last_mover()) == first_seat ? 1 : -1;
+    }
+
+  private:
+    Options _o;
+
+    static void _Play(C4Game &game, int col)
+    {
+      game.Play(new C4Move(game.AvailableRow(std::size_t(col)), col, *(game.players()->at(game.turning_player())->pieces().front())));
+    }
+  };
+} // namespace c4
+
+#endif //C4_MATCH_H_
@@ -0,0 +1,389 @@
+#ifndef C4_NNUE_H_
+#define C4_NNUE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../boardgame/bgcpu.h"
+#include "../boardgame/bglog.h"
+#include "c4bitboard.h"
+#include "c4game.h"
+
+namespace c4
+{
+  /**
+   * @brief small quantized network scoring positions for the side to move
+   * @details input: one feature per (stone owner, cell) seen from each mover, 2 x 42 per perspective,
+   * layer 0 is a sum of int16 columns kept in an Accumulator and updated one stone at a time,
+   * its clipped outputs (side to move first) feed an int8 layer of kL1 neurons and a single int8 output,
+   * the result is divided by `scale` to match the C4Evaluator range
+   *
+   * file, little endian: Header, then
+   * int16 ft_bias[kHidden], int16 ft[kFeatures][kHidden],
+   * int32 l1_bias[kL1], int8 l1[kL1][2 * kHidden],
+   * int32 out_bias, int8 out[kL1]
+   * @code .cpp
+   * auto net = std::make_shared<C4Nnue>();
+   * if (net->Load("c4.nnue"))
+   *   ai.set_network(net);
+   * @endcode
+   */
+  class C4Nnue
+  {
+  public:
+    static constexpr char kMagic[4] = {'C', '4', 'N', 'N'};
+    static constexpr std::uint32_t kVersion = 1;
+
+    static constexpr int kFeatures = 2 * bitboard::kCells; //own stones, then the other mover's
+    static constexpr int kHidden = 64;                    //accumulator width per perspective
+    static constexpr int kL1 = 32;                        //neurons of the second layer
+    static constexpr int kClip = 127;                     //activations are clipped to [0, kClip]
+
+    static_assert(kHidden % 32 == 0 && kL1 % 4 == 0, "the AVX2 kernel works on 32 inputs and 4 neurons at a time");
+
+    struct Header
+    {
+      char magic[4];
+      std::uint32_t version;
+      std::uint32_t rows;
+      std::uint32_t cols;
+      std::uint32_t hidden;
+      std::uint32_t l1;
+      std::int32_t shift; //layer 1 sums are shifted right by this much before clipping
+      std::int32_t scale; //the output is divided by this much
+    };
+
+    struct Weights
+    {
+      alignas(32) std::int16_t ft_bias[kHidden]{};
+      alignas(32) std::int16_t ft[kFeatures][kHidden]{};
+      alignas(32) std::int8_t l1[kL1][2 * kHidden]{};
+      std::int32_t l1_bias[kL1]{};
+      std::int8_t out[kL1]{};
+      std::int32_t out_bias{0};
+      std::int32_t shift{6};
+      std::int32_t scale{16};
+    };
+
+    //layer 0 outputs of both perspectives, [0] sees the first mover's stones as own
+    struct Accumulator
+    {
+      alignas(32) std::int16_t v[2][kHidden];
+    };
+
+    //all weights zero, every position scores 0
+    C4Nnue() : _w{std::make_unique<Weights>()} {}
+    explicit C4Nnue(bg::simd::Enum isa) : C4Nnue() { _isa = isa; }
+
+    C4Nnue(const C4Nnue &o) : _w{std::make_unique<Weights>(*o._w)}, _isa{o._isa} {}
+    C4Nnue &operator=(const C4Nnue &o)
+    {
+      *_w = *o._w;
+      _isa = o._isa;
+      return *this;
+    }
+
+    //-----------------------GETTERS-------------------------
+
+    inline const Weights &weights() const noexcept { return *_w; }
+    //for trainers and tests, accumulators made before a change are stale
+    inline Weights &weights() noexcept { return *_w; }
+    inline auto isa() const noexcept { return _isa; }
+    inline void set_isa(bg::simd::Enum isa) noexcept { _isa = isa; }
+
+    //feature of a stone of `mover` (0 first, 1 second) on bit `bit`, seen by `perspective`
+    static inline int Feature(int perspective, int mover, int bit) noexcept
+    {
+      return (mover == perspective ? 0 : bitboard::kCells) + bit - bit / bitboard::kStride;
+    }
+
+    //-----------------------FILES---------------------------
+
+    /**
+     * @brief reads weights written by the training pipeline or by Save
+     * @return true | false if missing, truncated or for another size, the weights are then unchanged
+     */
+    bool Load(const std::string &path)
+    {
+      std::FILE *f = std::fopen(path.c_str(), "rb");
+      if (!f)
+        return false;
+
+      Header h{};
+      auto w = std::make_unique<Weights>();
+      bool ok = std::fread(&h, sizeof(h), 1, f) == 1 && !std::memcmp(h.magic, kMagic, 4) && h.version == kVersion &&
+                h.rows == bitboard::kRows && h.cols == bitboard::kCols && h.hidden == kHidden && h.l1 == kL1 &&
+                h.shift >= 0 && h.shift < 31 && h.scale > 0;
+      ok = ok && _Read(f, w->ft_bias, kHidden) && _Read(f, &w->ft[0][0], kFeatures * kHidden) &&
+           _Read(f, w->l1_bias, kL1) && _Read(f, &w->l1[0][0], kL1 * 2 * kHidden) &&
+           _Read(f, &w->out_bias, 1) && _Read(f, w->out, kL1) && std::fgetc(f) == EOF;
+      std::fclose(f);
+
+      if (!ok)
+      {
+        BGLOG_WARN("C4Nnue::Load", "{} is not a network for this build", path);
+        return false;
+      }
+      w->shift = h.shift;
+      w->scale = h.scale;
+      _w = std::move(w);
+      return true;
+    }
+
+    //writes the format read by Load
+    bool Save(const std::string &path) const
+    {
+      std::FILE *f = std::fopen(path.c_str(), "wb");
+      if (!f)
+        return false;
+
+      Header h{};
+      std::memcpy(h.magic, kMagic, 4);
+      h.version = kVersion;
+      h.rows = bitboard::kRows;
+      h.cols = bitboard::kCols;
+      h.hidden = kHidden;
+      h.l1 = kL1;
+      h.shift = _w->shift;
+      h.scale = _w->scale;
+
+      const Weights &w = *_w;
+      bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 && _Write(f, w.ft_bias, kHidden) &&
+                _Write(f, &w.ft[0][0], kFeatures * kHidden) && _Write(f, w.l1_bias, kL1) &&
+                _Write(f, &w.l1[0][0], kL1 * 2 * kHidden) && _Write(f, &w.out_bias, 1) && _Write(f, w.out, kL1);
+      return std::fclose(f) == 0 && ok;
+    }
+
+    //-----------------------ACCUMULATOR---------------------
+
+    /**
+     * @brief layer 0 from scratch
+     * @param first stones of the first mover
+     * @param second stones of the second mover
+     */
+    void Refresh(Accumulator &acc, bitboard::bits_t first, bitboard::bits_t second) const noexcept
+    {
+      for (int p = 0; p < 2; ++p)
+      {
+        std::memcpy(acc.v[p], _w->ft_bias, sizeof(acc.v[p]));
+        for (int mover = 0; mover < 2; ++mover)
+          for (bitboard::bits_t b = mover ? second : first; b; b &= b - 1)
+            _Add(acc.v[p], acc.v[p], _w->ft[Feature(p, mover, _Bit(b))]);
+      }
+    }
+
+    //`to` = `from` plus a stone of `mover` on `cell`, the usual step of a search
+    inline void Push(const Accumulator &from, Accumulator &to, int mover, bitboard::bits_t cell) const noexcept
+    {
+      const int bit = _Bit(cell);
+      _Add(from.v[0], to.v[0], _w->ft[Feature(0, mover, bit)]);
+      _Add(from.v[1], to.v[1], _w->ft[Feature(1, mover, bit)]);
+    }
+
+    //in place, for a stone placed on a game
+    inline void Add(Accumulator &acc, int mover, bitboard::bits_t cell) const noexcept { Push(acc, acc, mover, cell); }
+
+    //in place, for a stone taken back
+    inline void Remove(Accumulator &acc, int mover, bitboard::bits_t cell) const noexcept
+    {
+      const int bit = _Bit(cell);
+      _Sub(acc.v[0], _w->ft[Feature(0, mover, bit)]);
+      _Sub(acc.v[1], _w->ft[Feature(1, mover, bit)]);
+    }
+
+    //-----------------------INFERENCE-----------------------
+
+    /**
+     * @brief score for the side to move
+     * @param stm 0 if the first mover is to move (even number of stones), 1 otherwise
+     */
+    inline int Evaluate(const Accumulator &acc, int stm) const noexcept
+    {
+      alignas(32) std::int32_t hidden[kL1];
+#if BG_X86
+      if (_isa == bg::simd::Enum::AVX2)
+        _AVX2(acc, stm, hidden);
+      else
+#endif
+        _Scalar(acc, stm, hidden);
+
+      std::int32_t out = _w->out_bias;
+      for (int j = 0; j < kL1; ++j)
+        out += hidden[j] * _w->out[j];
+      return out / _w->scale;
+    }
+
+    //score of a position without an accumulator, slow
+    int Evaluate(bitboard::bits_t own, bitboard::bits_t mask) const noexcept
+    {
+      const int stm = bitboard::Count(mask) & 1;
+      Accumulator acc;
+      Refresh(acc, stm ? own ^ mask : own, stm ? own : own ^ mask);
+      return Evaluate(acc, stm);
+    }
+
+  private:
+    std::unique_ptr<Weights> _w;
+    bg::simd::Enum _isa{bg::simd::Best()};
+
+    static inline int _Bit(bitboard::bits_t cell) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return __builtin_ctzll(cell);
+#else
+      int bit = 0;
+      for (; !(cell & 1); cell >>= 1)
+        ++bit;
+      return bit;
+#endif
+    }
+
+    template <class V>
+    static bool _Read(std::FILE *f, V *v, std::size_t n) { return std::fread(v, sizeof(V), n, f) == n; }
+    template <class V>
+    static bool _Write(std::FILE *f, const V *v, std::size_t n) { return std::fwrite(v, sizeof(V), n, f) == n; }
+
+    //plain loops, vectorized by the compiler at the translation unit's isa
+    static inline void _Add(const std::int16_t *from, std::int16_t *to, const std::int16_t *w) noexcept
+    {
+      for (int i = 0; i < kHidden; ++i)
+        to[i] = std::int16_t(from[i] + w[i]);
+    }
+
+    static inline void _Sub(std::int16_t *acc, const std::int16_t *w) noexcept
+    {
+      for (int i = 0; i < kHidden; ++i)
+        acc[i] = std::int16_t(acc[i] - w[i]);
+    }
+
+    //-------------------------SCALAR-----------------------------
+
+    void _Scalar(const Accumulator &acc, int stm, std::int32_t *hidden) const noexcept
+    {
+      std::uint8_t in[2 * kHidden];
+      for (int i = 0; i < kHidden; ++i)
+      {
+        in[i] = std::uint8_t(std::clamp<int>(acc.v[stm][i], 0, kClip));
+        in[kHidden + i] = std::uint8_t(std::clamp<int>(acc.v[stm ^ 1][i], 0, kClip));
+      }
+
+      for (int j = 0; j < kL1; ++j)
+      {
+        std::int32_t sum = 0;
+        for (int i = 0; i < 2 * kHidden; ++i)
+          sum += in[i] * _w->l1[j][i];
+        hidden[j] = std::clamp<std::int32_t>((sum + _w->l1_bias[j]) >> _w->shift, 0, kClip);
+      }
+    }
+
+#if BG_X86
+    //-------------------------AVX2-------------------------------
+
+    BG_TARGET_AVX2 void _AVX2(const Accumulator &acc, int stm, std::int32_t *hidden) const noexcept
+    {
+      const __m256i zero = _mm256_setzero_si256();
+
+      //clipped relu, 32 int16 -> 32 uint8 in order, kept in registers
+      __m256i x[2 * kHidden / 32];
+      for (int half = 0; half < 2; ++half)
+      {
+        const std::int16_t *a = acc.v[stm ^ half];
+        for (int i = 0; i < kHidden; i += 32)
+        {
+          const __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i *>(a + i));
+          const __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i *>(a + i + 16));
+          const __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(lo, hi), zero); //[0, 127]
+          x[(half * kHidden + i) / 32] = _mm256_permute4x64_epi64(packed, 0xD8);
+        }
+      }
+
+      //uint8 x int8 dot products, pairs summed to int16 (at most 2 * 127 * 128) then to int32,
+      //four neurons reduced together
+      const __m256i ones = _mm256_set1_epi16(1);
+      const __m128i clip = _mm_set1_epi32(kClip), shift = _mm_cvtsi32_si128(_w->shift);
+      for (int j = 0; j < kL1; j += 4)
+      {
+        __m256i sum[4];
+        for (int k = 0; k < 4; ++k)
+        {
+          sum[k] = zero;
+          for (int i = 0; i < 2 * kHidden / 32; ++i)
+          {
+            const __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i *>(_w->l1[j + k] + 32 * i));
+            sum[k] = _mm256_add_epi32(sum[k], _mm256_madd_epi16(_mm256_maddubs_epi16(x[i], w), ones));
+          }
+        }
+        const __m256i h = _mm256_hadd_epi32(_mm256_hadd_epi32(sum[0], sum[1]), _mm256_hadd_epi32(sum[2], sum[3]));
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+        s = _mm_add_epi32(s, _mm_loadu_si128(reinterpret_cast<const __m128i *>(_w->l1_bias + j)));
+        s = _mm_min_epi32(_mm_max_epi32(_mm_sra_epi32(s, shift), _mm_setzero_si128()), clip);
+        _mm_store_si128(reinterpret_cast<__m128i *>(hidden + j), s);
+      }
+    }
+#endif //BG_X86
+  };
+
+  /**
+   * @brief keeps an accumulator in step with a C4Game, one Push per Apply and one pop per Undo
+   * @code .cpp
+   * C4NnueTracker tracker{net, game};
+   * game.MakeMove();
+   * int score = tracker.Evaluate();
+   * game.Undo();
+   * @endcode
+   */
+  class C4NnueTracker : public C4GameListener
+  {
+  public:
+    C4NnueTracker(std::shared_ptr<const C4Nnue> net, C4Game &game) : _net{std::move(net)}, _game{game}
+    {
+      _stack.resize(bitboard::kCells + 1);
+      OnReset(game);
+      _game.set_listener(this);
+    }
+
+    C4NnueTracker(const C4NnueTracker &) = delete;
+    C4NnueTracker &operator=(const C4NnueTracker &) = delete;
+
+    ~C4NnueTracker() override { _game.set_listener(nullptr); }
+
+    inline const C4Nnue::Accumulator &accumulator() const noexcept { return _stack[_top]; }
+
+    //score of the game's position for the side to move
+    inline int Evaluate() const noexcept { return _net->Evaluate(_stack[_top], _game.ply() & 1); }
+
+    void OnApply(int mover, int row, int col) override
+    {
+      _net->Push(_stack[_top], _stack[_top + 1], mover, bitboard::Cell(row, col));
+      ++_top;
+    }
+
+    void OnUndo(int mover, int row, int col) override
+    {
+      if (_top > 0)
+        --_top; //the parent is still on the stack
+      else
+        _net->Remove(_stack[0], mover, bitboard::Cell(row, col));
+    }
+
+    void OnReset(const C4Game &game) override
+    {
+      const auto own = game.own(), opp = game.opp();
+      _top = 0;
+      _net->Refresh(_stack[0], game.ply() & 1 ? opp : own, game.ply() & 1 ? own : opp);
+    }
+
+  private:
+    std::shared_ptr<const C4Nnue> _net;
+    C4Game &_game;
+    std::vector<C4Nnue::Accumulator> _stack; //one per stone since the last reset
+    int _top{0};
+  };
+} // namespace c4
+
+#endif //C4_NNUE_H_
@@ -0,0 +1,715 @@
+#ifndef C4_SERVER_H_
+#define C4_SERVER_H_
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../boardgame/bglog.h"
+#include "../boardgame/bgpool.h"
+#include "../boardgame/bgstats.h"
+#include "c4ai.h"
+#include "c4cache.h"
+#include "c4game.h"
+#include "c4state.h"
+#include "c4tablebase.h"
+#include "c4ttable.h"
+#include "c4wire.h"
+
+namespace c4
+{
+  /**
+   * @brief player whose moves arrive over the wire, SuggestMove plays the column set last
+   */
+  class C4Remote : public C4Player
+  {
+  public:
+    C4Remote(std::string name, C4Piece p = {'R'}) : Player(name, 0, p) {}
+
+    inline void set_next(int col) noexcept { _next = col; }
+
+    C4Move *SuggestMove(const BGame &state) const override
+    {
+      const C4Game *c4state = dynamic_cast<const C4Game *>(&state);
+      if (!c4state || _next < 0 || _next >= C4Game::kCols)
+        return nullptr;
+      return new C4Move(c4state->AvailableRow(std::size_t(_next)), _next, *(_pieces.front()));
+    }
+
+    C4Remote *copy() const override
+    {
+      return new C4Remote(*this);
+    }
+    C4Remote *move() override
+    {
+      return new C4Remote(std::forward<C4Remote>(*this));
+    }
+
+  private:
+    int _next{-1};
+  };
+
+  /**
+   * @brief serves many C4Game sessions over TCP or a Unix socket, one epoll loop plus engine threads
+   * @details the loop owns sockets and sessions, it applies client moves itself and hands
+   * engine moves to the thread pool at high priority, a session is busy until its engine move is back,
+   * idle sessions are a C4State, a C4Game only exists while a move is played,
+   * frames are described in c4wire.h
+   * @code .cpp
+   * C4Server::Options o;
+   * o.unix_path = "/tmp/c4.sock";
+   * C4Server server{o};
+   * if (server.Listen())
+   *   server.Run(); //until Stop() from another thread
+   * @endcode
+   */
+  class C4Server
+  {
+  public:
+    struct Options
+    {
+      std::string unix_path{};                //listen here if set
+      std::string host{"127.0.0.1"};          //else on TCP host:port
+      std::uint16_t port{4004};               //0 picks a free port
+      bg::ThreadPool *pool{nullptr};          //engines, nullptr for the shared pool
+      std::size_t max_sessions{1u << 20};
+      int max_level{12};                      //deepest search a client may ask for
+      int report_seconds{10};                 //log a Report() this often, 0 never
+      driver::Enum driver{driver::Enum::PVS}; //engine search
+      std::size_t tt_megabytes{64};           //table shared by every engine, 0 for none
+      std::string tt_path{};                  //snapshot loaded by Listen and saved when Run returns
+      int tt_save_seconds{0};                 //also save the snapshot this often, 0 never
+      std::size_t cache_megabytes{16};        //best moves shared by every session, 0 for none
+      std::string tb_path{};                  //C4Tablebase opened by Listen and probed by every engine, none if empty
+    };
+
+    explicit C4Server(const Options &options) : _o{options}
+    {
+      if (_o.tt_megabytes)
+        _tt = std::make_shared<C4TTable>(_o.tt_megabytes);
+      if (_o.cache_megabytes)
+        _cache = std::make_shared<C4MoveCache>(_o.cache_megabytes);
+    }
+
+    C4Server(const C4Server &) = delete;
+    C4Server &operator=(const C4Server &) = delete;
+
+    virtual ~C4Server()
+    {
+      _StopEngines();
+      for (auto &c : _conns)
+        ::close(c.second.fd);
+      _Close(_listen);
+      _Close(_wake);
+      _Close(_epoll);
+    }
+
+    //-----------------------GETTERS-------------------------
+
+    //bound TCP port, useful with port 0
+    inline auto port() const noexcept { return _o.port; }
+    inline auto sessions() const noexcept { return _sessions.size(); }
+    //most sessions open at once, from the Run thread or after Run
+    inline auto peak() const noexcept { return _peak; }
+
+    //-----------------------FUNCTIONS-----------------------
+
+    /**
+     * @brief binds the socket and starts the engine threads
+     * @return true | false if the address cannot be used
+     */
+    bool Listen()
+    {
+      _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+      _wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (_epoll < 0 || _wake < 0 || !_Bind())
+        return false;
+
+      _Watch(_listen, kListenId, EPOLLIN);
+      _Watch(_wake, kWakeId, EPOLLIN);
+
+      //warm start from the process this one replaces
+      if (_tt && !_o.tt_path.empty() && !_tt->Load(_o.tt_path))
+        BGLOG_INFO("C4Server::Listen", "no snapshot at {}, starting cold", _o.tt_path);
+      if (!_o.tb_path.empty() && !_tb.Open(_o.tb_path))
+        BGLOG_WARN("C4Server::Listen", "no tablebase at {}, engines search to the end", _o.tb_path);
+
+      BGLOG_INFO("C4Server::Listen", "{} engines on {}", _pool().size(),
+                 _o.unix_path.empty() ? _o.host + ":" + std::to_string(_o.port) : _o.unix_path);
+      return true;
+    }
+
+    /**
+     * @brief serves until Stop()
+     */
+    void Run()
+    {
+      epoll_event events[256];
+      std::uint64_t next_report = bg::stats::Now() + std::uint64_t(_o.report_seconds) * 1000000000ull;
+      std::uint64_t next_save = bg::stats::Now() + std::uint64_t(_o.tt_save_seconds) * 1000000000ull;
+
+      while (!_stop.load(std::memory_order_acquire))
+      {
+        const int n = ::epoll_wait(_epoll, events, 256, 100);
+        for (int i = 0; i < n; ++i)
+        {
+          const std::uint64_t id = events[i].data.u64;
+          if (id == kListenId)
+            _Accept();
+          else if (id == kWakeId)
+            _Completed();
+          else
+            _Ready(id, events[i].events);
+        }
+
+        if (_o.report_seconds > 0 && bg::stats::Now() >= next_report)
+        {
+          _Log();
+          next_report = bg::stats::Now() + std::uint64_t(_o.report_seconds) * 1000000000ull;
+        }
+
+        if (_o.tt_save_seconds > 0 && bg::stats::Now() >= next_save)
+        {
+          _SaveAsync();
+          next_save = bg::stats::Now() + std::uint64_t(_o.tt_save_seconds) * 1000000000ull;
+        }
+      }
+      _Log();
+      //a periodic save may still be writing the same file
+      _StopEngines();
+      _Save();
+    }
+
+    //thread safe, Run returns within ~100ms
+    void Stop() noexcept
+    {
+      _stop.store(true, std::memory_order_release);
+      const std::uint64_t one = 1;
+      if (_wake >= 0)
+        (void)::write(_wake, &one, sizeof(one));
+    }
+
+    /**
+     * @brief one line summary of sessions and latencies, call it from the Run thread or after Run
+     * @details `reply` is a client move in to the answer out, `engine` is the search alone
+     */
+    std::string Report() const
+    {
+      const double cores = double(std::max(1u, std::thread::hardware_concurrency()));
+      std::ostringstream s;
+      auto percentiles = [&s](const char *name, const bg::stats::Histogram &h) {
+        s << " " << name << "_us p50 " << h.Percentile(0.50) / 1000
+          << " p90 " << h.Percentile(0.90) / 1000
+          << " p99 " << h.Percentile(0.99) / 1000
+          << " max " << h.max_ns / 1000;
+      };
+
+      s << "sessions " << _sessions.size() << " peak " << _peak
+        << " peak_per_hw_thread " << double(_peak) / cores
+        << " moves " << _reply.count;
+      percentiles("reply", _reply);
+      percentiles("engine", _engine);
+      if (_cache)
+        s << " cache_hit_rate " << _cache->stats().hit_rate();
+      return s.str();
+    }
+
+  protected:
+    static constexpr std::uint64_t kListenId = 0;
+    static constexpr std::uint64_t kWakeId = 1;
+
+    struct Session
+    {
+      C4State state;          //whole game, `user` is the engine seat
+      std::uint64_t conn;     //connection id, 0 once the client is gone
+      std::uint64_t start{0}; //when the request that made it busy arrived
+      std::uint64_t think{0}; //engine time of the last search
+      std::uint32_t id;
+      std::int8_t played{-1}; //column of the last engine move
+      bool busy{false};       //queued for or inside an engine
+    };
+
+    struct Conn
+    {
+      int fd;
+      std::vector<unsigned char> in, out;
+      std::vector<std::uint32_t> sessions;
+    };
+
+    Options _o;
+    int _epoll{-1}, _listen{-1}, _wake{-1};
+    std::uint64_t _next_conn{2};
+    std::uint32_t _next_session{1};
+    std::unordered_map<std::uint64_t, Conn> _conns;
+    std::unordered_map<std::uint32_t, std::unique_ptr<Session>> _sessions;
+    std::size_t _peak{0};
+    bg::stats::Histogram _reply, _engine;
+
+    //sessions go to the pool busy and come back through _done
+    std::mutex _mutex;
+    std::condition_variable _idle; //signalled when _thinking drops to 0
+    std::vector<Session *> _done;
+    std::size_t _thinking{0};      //sessions and snapshots inside the pool
+    std::atomic<bool> _stop{false};
+
+    std::shared_ptr<C4TTable> _tt;       //shared by every engine
+    std::shared_ptr<C4MoveCache> _cache; //finished engine searches, shared by every session
+    C4Tablebase _tb;                     //late positions, read only once Listen returns
+    std::atomic<bool> _saving{false};    //a snapshot is being written
+
+  private:
+    //Report() split in fields, log arguments are kept short
+    void _Log() const
+    {
+      const double cores = double(std::max(1u, std::thread::hardware_concurrency()));
+      BGLOG_INFO("C4Server", "sessions {} peak {} peak_per_hw_thread {} moves {}", _sessions.size(), _peak,
+                 double(_peak) / cores, _reply.count);
+      BGLOG_INFO("C4Server", "reply_us p50 {} p90 {} p99 {} max {}", _reply.Percentile(0.50) / 1000,
+                 _reply.Percentile(0.90) / 1000, _reply.Percentile(0.99) / 1000, _reply.max_ns / 1000);
+      BGLOG_INFO("C4Server", "engine_us p50 {} p90 {} p99 {} max {}", _engine.Percentile(0.50) / 1000,
+                 _engine.Percentile(0.90) / 1000, _engine.Percentile(0.99) / 1000, _engine.max_ns / 1000);
+      if (_cache)
+      {
+        const C4MoveCache::Stats c = _cache->stats();
+        BGLOG_INFO("C4Server", "cache hit_rate {} hits {} size {} evictions {}", c.hit_rate(), c.hits, c.size,
+                   c.evictions);
+      }
+    }
+
+    //------------------------SOCKETS------------------------
+
+    static void _Close(int &fd) noexcept
+    {
+      if (fd >= 0)
+        ::close(fd);
+      fd = -1;
+    }
+
+    inline void _Watch(int fd, std::uint64_t id, std::uint32_t events, int op = EPOLL_CTL_ADD)
+    {
+      epoll_event ev{};
+      ev.events = events;
+      ev.data.u64 = id;
+      ::epoll_ctl(_epoll, op, fd, &ev);
+    }
+
+    bool _Bind()
+    {
+      if (!_o.unix_path.empty())
+      {
+        sockaddr_un addr{};
+        if (_o.unix_path.size() >= sizeof(addr.sun_path))
+          return false;
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, _o.unix_path.c_str(), _o.unix_path.size());
+        ::unlink(_o.unix_path.c_str());
+
+        _listen = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        return _listen >= 0 && ::bind(_listen, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0 &&
+               ::listen(_listen, SOMAXCONN) == 0;
+      }
+
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(_o.port);
+      if (::inet_pton(AF_INET, _o.host.c_str(), &addr.sin_addr) != 1)
+        return false;
+
+      _listen = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      const int one = 1;
+      if (_listen < 0 || ::setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+          ::bind(_listen, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+          ::listen(_listen, SOMAXCONN) != 0)
+        return false;
+
+      socklen_t len = sizeof(addr);
+      ::getsockname(_listen, reinterpret_cast<sockaddr *>(&addr), &len);
+      _o.port = ntohs(addr.sin_port);
+      return true;
+    }
+
+    void _Accept()
+    {
+      for (;;)
+      {
+        const int fd = ::accept4(_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+          return;
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); //fails harmlessly on Unix sockets
+
+        const std::uint64_t id = _next_conn++;
+        _conns[id] = Conn{fd, {}, {}, {}};
+        _Watch(fd, id, EPOLLIN | EPOLLRDHUP);
+        BGLOG_DEBUG("C4Server::Accept", "connection {} fd {}", id, fd);
+      }
+    }
+
+    void _Ready(std::uint64_t id, std::uint32_t events)
+    {
+      auto it = _conns.find(id);
+      if (it == _conns.end())
+        return;
+      Conn &c = it->second;
+
+      if (events & EPOLLOUT)
+        _Flush(id, c);
+
+      if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+      {
+        unsigned char buf[4096];
+        for (;;)
+        {
+          const ssize_t got = ::read(c.fd, buf, sizeof(buf));
+          if (got > 0)
+          {
+            c.in.insert(c.in.end(), buf, buf + got);
+            continue;
+          }
+          if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+          {
+            _Drop(id);
+            return;
+          }
+          break;
+        }
+
+        std::size_t at = 0;
+        for (; at + wire::kFrame <= c.in.size(); at += wire::kFrame)
+          _Handle(id, wire::Decode(c.in.data() + at));
+
+        //_Handle never drops the connection, c is still valid
+        c.in.erase(c.in.begin(), c.in.begin() + std::ptrdiff_t(at));
+        _Flush(id, c);
+      }
+    }
+
+    void _Send(std::uint64_t conn, const wire::Frame &f)
+    {
+      auto it = _conns.find(conn);
+      if (it == _conns.end())
+        return;
+      auto &out = it->second.out;
+      out.resize(out.size() + wire::kFrame);
+      wire::Encode(f, out.data() + out.size() - wire::kFrame);
+    }
+
+    void _Flush(std::uint64_t id, Conn &c)
+    {
+      std::size_t sent = 0;
+      while (sent < c.out.size())
+      {
+        const ssize_t n = ::send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+          break;
+        sent += std::size_t(n);
+      }
+      c.out.erase(c.out.begin(), c.out.begin() + std::ptrdiff_t(sent));
+      //ask for EPOLLOUT only while something is left
+      _Watch(c.fd, id, EPOLLIN | EPOLLRDHUP | (c.out.empty() ? 0u : std::uint32_t(EPOLLOUT)), EPOLL_CTL_MOD);
+    }
+
+    //closes a connection, its sessions go with it once no engine holds them
+    void _Drop(std::uint64_t id)
+    {
+      auto it = _conns.find(id);
+      if (it == _conns.end())
+        return;
+      for (const auto sid : it->second.sessions)
+      {
+        auto s = _sessions.find(sid);
+        if (s == _sessions.end())
+          continue;
+        if (s->second->busy)
+          s->second->conn = 0; //_Completed erases it
+        else
+          _sessions.erase(s);
+      }
+      ::close(it->second.fd);
+      _conns.erase(it);
+      BGLOG_DEBUG("C4Server::Drop", "connection {}", id);
+    }
+
+    //------------------------PROTOCOL-----------------------
+
+    void _Handle(std::uint64_t conn, const wire::Frame &f)
+    {
+      using wire::op::Enum;
+
+      switch (f.op)
+      {
+      case Enum::PING:
+        _Send(conn, {Enum::PONG, f.arg, f.aux, f.session});
+        return;
+      case Enum::NEW:
+        _New(conn, f);
+        return;
+      case Enum::MOVE:
+        _Move(conn, f);
+        return;
+      case Enum::END:
+      {
+        auto s = _Find(conn, f.session);
+        if (!s)
+          return;
+        auto &list = _conns[conn].sessions;
+        list.erase(std::remove(list.begin(), list.end(), f.session), list.end());
+        if (s->busy)
+          s->conn = 0;
+        else
+          _sessions.erase(f.session);
+        _Send(conn, {Enum::ENDED, 0, 0, f.session});
+        return;
+      }
+      default:
+        _Error(conn, f.session, wire::error::Enum::BAD_OP);
+      }
+    }
+
+    inline void _Error(std::uint64_t conn, std::uint32_t session, wire::error::Enum e)
+    {
+      _Send(conn, {wire::op::Enum::ERROR, std::uint8_t(e), 0, session});
+    }
+
+    //session owned by conn, or nullptr after sending NO_SESSION
+    Session *_Find(std::uint64_t conn, std::uint32_t id)
+    {
+      auto it = _sessions.find(id);
+      if (it == _sessions.end() || it->second->conn != conn)
+      {
+        _Error(conn, id, wire::error::Enum::NO_SESSION);
+        return nullptr;
+      }
+      return it->second.get();
+    }
+
+    void _New(std::uint64_t conn, const wire::Frame &f)
+    {
+      if (_sessions.size() >= _o.max_sessions)
+        return _Error(conn, 0, wire::error::Enum::FULL);
+
+      const int level = std::clamp(int(f.arg), 1, _o.max_level);
+      const bool engine_first = f.aux != 0;
+
+      auto s = std::make_unique<Session>();
+      s->id = _next_session++;
+      s->conn = conn;
+      s->state.user = engine_first ? 0 : 1;
+      s->state.piece[s->state.user] = 'A';
+      s->state.piece[1 - s->state.user] = 'R';
+      s->state.level[s->state.user] = std::uint8_t(level);
+
+      Session *raw = s.get();
+      _sessions.emplace(s->id, std::move(s));
+      _conns[conn].sessions.push_back(raw->id);
+      _peak = std::max(_peak, _sessions.size());
+      _Send(conn, {wire::op::Enum::STARTED, std::uint8_t(level), std::uint8_t(engine_first), raw->id});
+
+      if (engine_first)
+        _Think(raw, bg::stats::Now());
+    }
+
+    void _Move(std::uint64_t conn, const wire::Frame &f)
+    {
+      const std::uint64_t start = bg::stats::Now();
+      Session *s = _Find(conn, f.session);
+      if (!s)
+        return;
+      if (s->busy)
+        return _Error(conn, f.session, wire::error::Enum::BUSY);
+
+      if (s->state.IsOver() || s->state.turn == s->state.user || f.arg >= C4Game::kCols)
+        return _Error(conn, f.session, wire::error::Enum::ILLEGAL_MOVE);
+
+      C4Game game = _Game(s->state);
+      static_cast<C4Remote *>(game.players()->at(game.turning_player()))->set_next(f.arg);
+      if (!game.MakeMove())
+        return _Error(conn, f.session, wire::error::Enum::ILLEGAL_MOVE);
+      const std::uint8_t user = s->state.user;
+      s->state = C4State::FromGame(game);
+      s->state.user = user; //FromGame leaves it 0
+
+      if (s->state.IsOver())
+      {
+        _Send(conn, {wire::op::Enum::MOVED, wire::kNoColumn, std::uint8_t(_Status(*s)), s->id});
+        _reply.Add(bg::stats::Now() - start);
+        return;
+      }
+      _Think(s, start);
+    }
+
+    //players seated as the state says, then the state's position
+    C4Game _Game(const C4State &state) const
+    {
+      C4Game game;
+      for (int seat = 0; seat < 2; ++seat)
+        if (seat == state.user)
+        {
+          C4AI engine{"engine", state.level[seat], C4Piece{state.piece[seat]}};
+          engine.set_ttable(_tt);
+          engine.set_move_cache(_cache);
+          engine.set_tablebase(_tb.IsOpen() ? &_tb : nullptr);
+          engine.set_driver(_o.driver, 0);
+          game.insert(engine);
+        }
+        else
+          game.insert(C4Remote{"client", C4Piece{state.piece[seat]}});
+      state.ToGame(game);
+      return game;
+    }
+
+    wire::status::Enum _Status(const Session &s) const
+    {
+      switch (bg::game::Enum(s.state.state))
+      {
+      case bg::game::Enum::OVER:
+        return s.state.winner == s.state.user ? wire::status::Enum::ENGINE_WON : wire::status::Enum::CLIENT_WON;
+      case bg::game::Enum::DRAW:
+        return wire::status::Enum::DRAW;
+      default:
+        return wire::status::Enum::NOTOVER;
+      }
+    }
+
+    //------------------------ENGINES------------------------
+
+    inline bg::ThreadPool &_pool() const { return _o.pool ? *_o.pool : bg::ThreadPool::Shared(); }
+
+    void _Think(Session *s, std::uint64_t start)
+    {
+      s->busy = true;
+      s->start = start;
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        ++_thinking;
+      }
+      _pool().Submit([this, s] { _Engine(s); }, bg::priority::Enum::HIGH);
+    }
+
+    //on a pool worker, the loop does not touch busy sessions
+    void _Engine(Session *s)
+    {
+      const std::uint64_t start = bg::stats::Now();
+      C4Game game = _Game(s->state);
+      game.MakeMove();
+      C4State after = C4State::FromGame(game);
+      after.user = s->state.user; //FromGame leaves it 0
+      s->think = bg::stats::Now() - start;
+
+      s->played = -1;
+      for (int c = 0; c < C4Game::kCols; ++c)
+        if (after.height[c] != s->state.height[c])
+          s->played = std::int8_t(c);
+      s->state = after;
+
+      //under the lock, _wake stays open until _StopEngines has seen _thinking reach 0
+      std::lock_guard<std::mutex> lock{_mutex};
+      _done.push_back(s);
+      const std::uint64_t one = 1;
+      (void)::write(_wake, &one, sizeof(one));
+      if (!--_thinking)
+        _idle.notify_all();
+    }
+
+    //engine moves back on the loop thread
+    void _Completed()
+    {
+      std::uint64_t n;
+      (void)::read(_wake, &n, sizeof(n));
+
+      std::vector<Session *> done;
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        done.swap(_done);
+      }
+
+      std::vector<std::uint64_t> touched;
+      for (Session *s : done)
+      {
+        s->busy = false;
+        if (!s->conn)
+        {
+          _sessions.erase(s->id);
+          continue;
+        }
+
+        const std::uint8_t col = s->played < 0 ? wire::kNoColumn : std::uint8_t(s->played);
+        _Send(s->conn, {wire::op::Enum::MOVED, col, std::uint8_t(_Status(*s)), s->id});
+        _reply.Add(bg::stats::Now() - s->start);
+        _engine.Add(s->think);
+        touched.push_back(s->conn);
+      }
+
+      std::sort(touched.begin(), touched.end());
+      touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+      for (const auto id : touched)
+      {
+        auto it = _conns.find(id);
+        if (it != _conns.end())
+          _Flush(id, it->second);
+      }
+    }
+
+    //------------------------SNAPSHOTS----------------------
+
+    bool _Save()
+    {
+      if (!_tt || _o.tt_path.empty())
+        return false;
+      const bool ok = _tt->Save(_o.tt_path);
+      if (!ok)
+        BGLOG_WARN("C4Server", "cannot save the table to {}", _o.tt_path);
+      return ok;
+    }
+
+    //on the pool at low priority, engines keep searching while the table is written
+    void _SaveAsync()
+    {
+      if (!_tt || _o.tt_path.empty() || _saving.exchange(true))
+        return;
+      {
+        std::lock_guard<std::mutex> lock{_mutex};
+        ++_thinking;
+      }
+      _pool().Submit([this] {
+        _Save();
+        _saving.store(false);
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (!--_thinking)
+          _idle.notify_all();
+      }, bg::priority::Enum::LOW);
+    }
+
+    //waits for the searches still on the pool, they point into _sessions
+    void _StopEngines()
+    {
+      std::unique_lock<std::mutex> lock{_mutex};
+      _idle.wait(lock, [this] { return !_thinking; });
+    }
+  };
+} // namespace c4
+
+#endif //__linux__
+
+#endif //C4_SERVER_H_
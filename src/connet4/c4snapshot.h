@@ -0,0 +1,188 @@
+#ifndef C4_SNAPSHOT_H_
+#define C4_SNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "c4bitboard.h"
+#include "c4game.h"
+#include "c4state.h"
+
+namespace c4
+{
+  /**
+   * @brief immutable view of a game, cheap to copy and to hand to other threads
+   * @details the position is a C4State, the moves a persistent list whose nodes are shared,
+   * reference counted, with the live game and with every other snapshot of the same game,
+   * taking, copying and Play are O(1), nothing is ever written in place
+   * @code .cpp
+   * C4SnapshotSource source{game};
+   * //...
+   * C4Snapshot s = source.Take(); //to a spectator, an analysis task, a history browser
+   * C4Snapshot line = s.Play(3);  //a variation, `s` and the game are untouched
+   * @endcode
+   */
+  class C4Snapshot
+  {
+  public:
+    //one stone of the history, linked to the stone before it
+    struct Step
+    {
+      std::int8_t col;
+      std::uint8_t ply; //stones before this one
+      std::shared_ptr<const Step> prev;
+    };
+
+    C4Snapshot() = default;
+    C4Snapshot(const C4State &state, std::shared_ptr<const Step> last) noexcept : _state{state}, _last{std::move(last)} {}
+
+    //-----------------------GETTERS-------------------------
+
+    inline const C4State &state() const noexcept { return _state; }
+    inline int ply() const noexcept { return _state.ply; }
+    inline auto key() const noexcept { return _state.key(); }
+    inline bool IsOver() const noexcept { return _state.IsOver(); }
+    //last stone played, nullptr if the history is empty
+    inline const Step *last() const noexcept { return _last.get(); }
+    //ply the history starts at, e.g. the ply a game was restored to
+    inline int base() const noexcept
+    {
+      const Step *s = _last.get();
+      while (s && s->prev)
+        s = s->prev.get();
+      return s ? s->ply : _state.ply;
+    }
+
+    //seat owning the cell, -1 if empty
+    inline int At(int row, int col) const noexcept
+    {
+      const auto cell = bitboard::Cell(row, col);
+      if (!(_state.mask & cell))
+        return -1;
+      return _state.first & cell ? _state.first_seat : 1 - _state.first_seat;
+    }
+
+    //columns played since base(), oldest first
+    std::vector<int> Moves() const
+    {
+      std::vector<int> moves;
+      for (const Step *s = _last.get(); s; s = s->prev.get())
+        moves.push_back(s->col);
+      return {moves.rbegin(), moves.rend()};
+    }
+
+    //-----------------------FUNCTIONS-----------------------
+
+    inline bool CanPlay(int col) const noexcept
+    {
+      return !IsOver() && col >= 0 && col < bitboard::kCols && _state.height[col] < bitboard::kRows;
+    }
+
+    /**
+     * @brief snapshot after the side to move plays `col`, sharing this one's history
+     * @return *this if the move is illegal
+     */
+    C4Snapshot Play(int col) const
+    {
+      if (!CanPlay(col))
+        return *this;
+
+      C4State s = _state;
+      const auto cell = bitboard::Cell(s.height[col], col);
+      const bool first = (s.ply & 1) == 0;
+      if (!s.ply)
+        s.first_seat = s.turn;
+      s.mask |= cell;
+      if (first)
+        s.first |= cell;
+      ++s.height[col];
+      s.last_mover = std::int8_t(s.turn);
+      //like Game::Play, the turn stays with the player who ended the game
+      if (bitboard::IsAligned(first ? s.first : s.first ^ s.mask))
+      {
+        s.state = std::uint8_t(bg::game::Enum::OVER);
+        s.winner = s.last_mover;
+      }
+      else if (s.ply + 1 == bitboard::kCells)
+        s.state = std::uint8_t(bg::game::Enum::DRAW);
+      else
+        s.turn = std::uint8_t((s.turn + 1) % 2);
+
+      auto step = std::make_shared<const Step>(Step{std::int8_t(col), s.ply, _last});
+      ++s.ply;
+      return {s, std::move(step)};
+    }
+
+    /**
+     * @brief overwrites the position of a game whose players are already seated
+     * @note the game gets the position, not the history, see C4State::ToGame
+     */
+    void ToGame(C4Game &game) const { _state.ToGame(game); }
+
+  private:
+    C4State _state;
+    std::shared_ptr<const Step> _last; //nullptr if no stone was played since base()
+  };
+
+  /**
+   * @brief keeps the history of a live game as C4Snapshot steps, so Take() is O(1)
+   * @details one small node per stone, an Undo only drops the game's reference to it,
+   * snapshots already taken keep their own
+   * @note takes the game's listener slot, a listener that was there keeps its events through `next`
+   */
+  class C4SnapshotSource : public C4GameListener
+  {
+  public:
+    explicit C4SnapshotSource(C4Game &game, C4GameListener *next = nullptr) : _game{game}, _next{next}
+    {
+      _Rebuild(game);
+      _game.set_listener(this);
+    }
+
+    C4SnapshotSource(const C4SnapshotSource &) = delete;
+    C4SnapshotSource &operator=(const C4SnapshotSource &) = delete;
+
+    ~C4SnapshotSource() override { _game.set_listener(_next); }
+
+    //the game as it is now
+    inline C4Snapshot Take() const { return {C4State::FromGame(_game), _last}; }
+
+    void OnApply(int mover, int row, int col) override
+    {
+      _last = std::make_shared<const C4Snapshot::Step>(C4Snapshot::Step{std::int8_t(col), std::uint8_t(_game.ply()), std::move(_last)});
+      if (_next)
+        _next->OnApply(mover, row, col);
+    }
+
+    void OnUndo(int mover, int row, int col) override
+    {
+      if (_last)
+        _last = _last->prev;
+      if (_next)
+        _next->OnUndo(mover, row, col);
+    }
+
+    void OnReset(const C4Game &game) override
+    {
+      _Rebuild(game);
+      if (_next)
+        _next->OnReset(game);
+    }
+
+  private:
+    C4Game &_game;
+    C4GameListener *_next;
+    std::shared_ptr<const C4Snapshot::Step> _last;
+
+    //steps for the moves the game can still undo
+    void _Rebuild(const C4Game &game)
+    {
+      _last.reset();
+      for (int ply = game.ply() - game.undoable(); ply < game.ply(); ++ply)
+        _last = std::make_shared<const C4Snapshot::Step>(C4Snapshot::Step{std::int8_t(game.history(ply)), std::uint8_t(ply), std::move(_last)});
+    }
+  };
+} // namespace c4
+
+#endif //C4_SNAPSHOT_H_
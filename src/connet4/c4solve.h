@@ -0,0 +1,562 @@
+#ifndef C4_SOLVE_H_
+#define C4_SOLVE_H_
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../boardgame/bglog.h"
+#include "c4ai.h"
+#include "c4bitboard.h"
+#include "c4ttable.h"
+
+namespace c4
+{
+  /* solver protocol, every message both ways is one 32 byte frame
+     byte 0       op
+     byte 1       depth   (plies to search, 0 to the end of the game)
+     byte 2..3    0
+     byte 4..7    unit id, little endian
+     byte 8..15   bitboard::Key of the position, little endian
+     byte 16..19  score, little endian two's complement, C4AI scale
+     byte 20..23  0
+     byte 24..31  nodes searched, little endian
+  */
+  namespace solve
+  {
+    constexpr std::size_t kFrame = 32;
+
+    namespace op
+    {
+      enum class Enum : std::uint8_t
+      {
+        WORK = 0x01, //coordinator: search `key` to `depth`
+        QUIT = 0x02, //coordinator: no more work
+
+        RESULT = 0x81, //worker: `score` and `nodes` of `unit`
+      };
+
+      inline const char *ToString(Enum value) noexcept
+      {
+        switch (value)
+        {
+        case Enum::WORK:
+          return "WORK";
+        case Enum::QUIT:
+          return "QUIT";
+        case Enum::RESULT:
+          return "RESULT";
+        }
+        return "UNKNOWN";
+      }
+    } // namespace op
+
+    struct Message
+    {
+      op::Enum op{op::Enum::WORK};
+      std::uint8_t depth{0};
+      std::uint32_t unit{0};
+      std::uint64_t key{0};
+      std::int32_t score{0};
+      std::uint64_t nodes{0};
+    };
+
+    inline void Encode(const Message &m, unsigned char *out) noexcept
+    {
+      std::memset(out, 0, kFrame);
+      out[0] = std::uint8_t(m.op);
+      out[1] = m.depth;
+      for (int i = 0; i < 4; ++i)
+        out[4 + i] = std::uint8_t(m.unit >> (8 * i));
+      for (int i = 0; i < 8; ++i)
+        out[8 + i] = std::uint8_t(m.key >> (8 * i));
+      for (int i = 0; i < 4; ++i)
+        out[16 + i] = std::uint8_t(std::uint32_t(m.score) >> (8 * i));
+      for (int i = 0; i < 8; ++i)
+        out[24 + i] = std::uint8_t(m.nodes >> (8 * i));
+    }
+
+    inline Message Decode(const unsigned char *in) noexcept
+    {
+      Message m;
+      m.op = op::Enum(in[0]);
+      m.depth = in[1];
+      std::uint32_t score = 0;
+      for (int i = 0; i < 4; ++i)
+        m.unit |= std::uint32_t(in[4 + i]) << (8 * i);
+      for (int i = 0; i < 8; ++i)
+        m.key |= std::uint64_t(in[8 + i]) << (8 * i);
+      for (int i = 0; i < 4; ++i)
+        score |= std::uint32_t(in[16 + i]) << (8 * i);
+      for (int i = 0; i < 8; ++i)
+        m.nodes |= std::uint64_t(in[24 + i]) << (8 * i);
+      m.score = std::int32_t(score);
+      return m;
+    }
+  } // namespace solve
+
+  /**
+   * @brief one end of a link between the coordinator and a worker, carrying solve::Message
+   * @details the coordinator only needs whole messages and a descriptor to poll,
+   * so workers can sit behind pipes, sockets or anything else with an fd
+   */
+  class C4Channel
+  {
+  public:
+    virtual ~C4Channel() = default;
+
+    //whole message or false, the channel is unusable after a false
+    virtual bool Send(const solve::Message &m) = 0;
+    //blocks for the next message, false if the other end is gone
+    virtual bool Receive(solve::Message &m) = 0;
+    //readable when a message is waiting or the other end is gone
+    virtual int fd() const noexcept = 0;
+  };
+
+  /**
+   * @brief C4Channel over a connected stream socket, e.g. one end of a socketpair or a TCP connection
+   */
+  class C4FdChannel : public C4Channel
+  {
+  public:
+    //owns `fd`
+    explicit C4FdChannel(int fd) noexcept : _fd{fd} {}
+    C4FdChannel(const C4FdChannel &) = delete;
+    C4FdChannel &operator=(const C4FdChannel &) = delete;
+    ~C4FdChannel() override { Close(); }
+
+    inline int fd() const noexcept override { return _fd; }
+
+    void Close() noexcept
+    {
+      if (_fd >= 0)
+        ::close(_fd);
+      _fd = -1;
+    }
+
+    bool Send(const solve::Message &m) override
+    {
+      unsigned char buf[solve::kFrame];
+      solve::Encode(m, buf);
+      return _Io(buf, false);
+    }
+
+    bool Receive(solve::Message &m) override
+    {
+      unsigned char buf[solve::kFrame];
+      if (!_Io(buf, true))
+        return false;
+      m = solve::Decode(buf);
+      return true;
+    }
+
+  private:
+    int _fd{-1};
+
+    //whole frame or nothing
+    bool _Io(unsigned char *buf, bool in)
+    {
+      for (std::size_t done = 0; done < solve::kFrame;)
+      {
+        const ssize_t n = in ? ::recv(_fd, buf + done, solve::kFrame - done, 0)
+                             : ::send(_fd, buf + done, solve::kFrame - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n <= 0)
+        {
+          Close();
+          return false;
+        }
+        done += std::size_t(n);
+      }
+      return true;
+    }
+  };
+
+  /**
+   * @brief worker side of the distributed solver, searches the positions it is sent
+   * @details one transposition table lives as long as the worker, units of one solve share
+   * most of their subtrees
+   */
+  class C4SolveWorker
+  {
+  public:
+    explicit C4SolveWorker(std::size_t megabytes = 64, driver::Enum d = driver::Enum::MTDF)
+        : _tt{std::make_shared<C4TTable>(megabytes)}, _driver{d} {}
+
+    /**
+     * @brief answers WORK messages until QUIT
+     * @return true on QUIT | false if the channel closed or sent something else
+     */
+    bool Serve(C4Channel &channel) const
+    {
+      using namespace bitboard;
+
+      solve::Message m;
+      while (channel.Receive(m))
+      {
+        if (m.op == solve::op::Enum::QUIT)
+          return true;
+        if (m.op != solve::op::Enum::WORK)
+          return false;
+
+        bits_t own, mask;
+        Decode(m.key, own, mask);
+        if (Key(own, mask) != m.key)
+          return false;
+
+        const int left = kCells - Count(mask);
+        C4AI ai{"solver", std::size_t(m.depth ? std::min<int>(m.depth, left) : left)};
+        ai.set_ttable(_tt);
+        ai.set_driver(_driver, 0);
+        const C4AI::Result r = ai.Search(own, mask);
+
+        m.op = solve::op::Enum::RESULT;
+        m.score = r.score;
+        m.nodes = r.nodes;
+        if (!channel.Send(m))
+          return false;
+      }
+      return false;
+    }
+
+  private:
+    std::shared_ptr<C4TTable> _tt;
+    driver::Enum _driver;
+  };
+
+  /**
+   * @brief solves a position with worker processes
+   * @details the tree is cut `split_depth` plies below the root, every distinct position at the cut is
+   * a unit of work, units are handed to workers a few at a time and their scores are backed up the
+   * cut tree by negamax, a worker that dies has its units handed out again and is replaced
+   * @code .cpp
+   * C4SolveCoordinator::Options o;
+   * o.workers = 4;
+   * C4SolveCoordinator solver{o};
+   * const auto r = solver.Solve(game.own(), game.mask());
+   * @endcode
+   */
+  class C4SolveCoordinator
+  {
+  public:
+    struct Options
+    {
+      std::size_t workers{4};
+      int split_depth{4};          //plies searched by the coordinator
+      int depth{0};                //plies searched from the root, 0 to the end of the game
+      std::size_t megabytes{64};   //table of each worker
+      std::string program;         //executable run as `program --solve-worker <fd> <megabytes>`, empty to fork only
+      int max_attempts{3};         //times a unit may be handed out before the solve fails
+      std::size_t in_flight{2};    //units sent to a worker ahead of its answers
+    };
+
+    struct Result
+    {
+      bool ok{false};          //false if a unit failed max_attempts times
+      int column{-1};          //-1 if the board is full
+      int score{0};            //negamax score of `column` for the side to move, C4AI scale
+      std::uint64_t nodes{0};  //positions visited by the workers
+      std::size_t units{0};
+      std::size_t restarts{0}; //workers replaced after dying
+    };
+
+    explicit C4SolveCoordinator(const Options &options) : _o{options} {}
+    C4SolveCoordinator(const C4SolveCoordinator &) = delete;
+    C4SolveCoordinator &operator=(const C4SolveCoordinator &) = delete;
+    virtual ~C4SolveCoordinator() { _StopWorkers(); }
+
+    inline const auto &options() const noexcept { return _o; }
+
+    /**
+     * @param own stones of the side to move
+     * @param mask all stones
+     */
+    Result Solve(bits_t own, bits_t mask)
+    {
+      using namespace bitboard;
+
+      _StopWorkers();
+      _units.clear();
+      _index.clear();
+      _Split(own, mask, std::max(0, _o.split_depth));
+
+      Result r;
+      r.units = _units.size();
+      std::deque<std::uint32_t> queue;
+      for (std::uint32_t i = 0; i < _units.size(); ++i)
+        queue.push_back(i);
+
+      std::size_t done = 0;
+      if (!queue.empty())
+        _workers.resize(std::min(std::max<std::size_t>(1, _o.workers), _units.size()));
+      for (auto &w : _workers)
+        if (!_Start(w))
+          return r;
+
+      std::vector<pollfd> fds;
+      while (done < _units.size())
+      {
+        fds.clear();
+        bool dead = false;
+        for (auto &w : _workers)
+        {
+          while (w.channel && w.sent.size() < _o.in_flight && !queue.empty())
+          {
+            const std::uint32_t id = queue.front();
+            solve::Message m;
+            m.depth = std::uint8_t(_UnitDepth());
+            m.unit = id;
+            m.key = _units[id].key;
+            if (!w.channel->Send(m))
+              break; //replaced below
+            queue.pop_front();
+            ++_units[id].attempts;
+            w.sent.push_back(id);
+          }
+          fds.push_back({w.channel->fd(), POLLIN, 0});
+          dead = dead || w.channel->fd() < 0;
+        }
+
+        if (::poll(fds.data(), fds.size(), dead ? 0 : -1) < 0 && errno != EINTR)
+          return r;
+
+        for (std::size_t i = 0; i < _workers.size(); ++i)
+        {
+          Worker &w = _workers[i];
+          if (w.channel->fd() >= 0 && !(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+
+          solve::Message m;
+          if (w.channel->fd() >= 0 && w.channel->Receive(m) && m.op == solve::op::Enum::RESULT && m.unit < _units.size() &&
+              std::find(w.sent.begin(), w.sent.end(), m.unit) != w.sent.end())
+          {
+            w.sent.erase(std::find(w.sent.begin(), w.sent.end(), m.unit));
+            Unit &u = _units[m.unit];
+            if (!u.done)
+            {
+              u.done = true;
+              u.score = m.score;
+              ++done;
+            }
+            r.nodes += m.nodes;
+            continue;
+          }
+
+          //dead or talking nonsense, its units go back to the queue
+          BGLOG_WARN("C4SolveCoordinator::Solve", "worker {} lost with {} units", int(w.pid), w.sent.size());
+          for (const std::uint32_t id : w.sent)
+          {
+            if (_units[id].attempts >= _o.max_attempts)
+            {
+              BGLOG_ERROR("C4SolveCoordinator::Solve", "unit {} failed {} times", id, _units[id].attempts);
+              return r;
+            }
+            queue.push_front(id);
+          }
+          w.sent.clear();
+          _Reap(w);
+          if (!_Start(w))
+            return r;
+          ++r.restarts;
+        }
+      }
+      _StopWorkers();
+
+      r.ok = true;
+      r.score = _Backup(own, mask, std::max(0, _o.split_depth), &r.column);
+      return r;
+    }
+
+  protected:
+    struct Unit
+    {
+      std::uint64_t key{0};
+      int score{0};
+      int attempts{0};
+      bool done{false};
+    };
+
+    struct Worker
+    {
+      pid_t pid{-1};
+      std::unique_ptr<C4Channel> channel;
+      std::vector<std::uint32_t> sent; //units without an answer yet
+    };
+
+    /**
+     * @brief starts a worker process
+     * @param pid [out] to reap when the channel closes, -1 if there is no process to reap
+     * @return channel to the worker | nullptr if it could not be started
+     */
+    virtual std::unique_ptr<C4Channel> _Spawn(pid_t &pid)
+    {
+      int sv[2];
+      if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0)
+        return nullptr;
+
+      pid = ::fork();
+      if (pid < 0)
+      {
+        ::close(sv[0]);
+        ::close(sv[1]);
+        return nullptr;
+      }
+      if (pid == 0)
+      {
+        ::close(sv[0]);
+        if (!_o.program.empty())
+        {
+          ::fcntl(sv[1], F_SETFD, 0); //kept across exec
+          const std::string fd = std::to_string(sv[1]), mb = std::to_string(_o.megabytes);
+          ::execl(_o.program.c_str(), _o.program.c_str(), "--solve-worker", fd.c_str(), mb.c_str(), (char *)nullptr);
+          ::_exit(127);
+        }
+
+        //the log writer thread did not survive the fork, and exit would wait for it
+        bg::logging::Logger::Get().set_level(bg::logging::Enum::OFF);
+        C4FdChannel channel{sv[1]};
+        ::_exit(C4SolveWorker{_o.megabytes}.Serve(channel) ? 0 : 1);
+      }
+
+      ::close(sv[1]);
+      return std::unique_ptr<C4Channel>(new C4FdChannel(sv[0]));
+    }
+
+  private:
+    Options _o;
+    std::vector<Unit> _units;
+    std::unordered_map<std::uint64_t, std::uint32_t> _index; //key to unit, transpositions share one
+    std::vector<Worker> _workers;
+
+    //plies each unit is searched, 0 to the end of the game
+    inline int _UnitDepth() const noexcept
+    {
+      return _o.depth ? std::max(1, _o.depth - std::max(0, _o.split_depth)) : 0;
+    }
+
+    inline bool _Start(Worker &w)
+    {
+      w.channel = _Spawn(w.pid);
+      if (!w.channel)
+        BGLOG_ERROR("C4SolveCoordinator::_Start", "cannot start a worker: {}", std::strerror(errno));
+      return bool(w.channel);
+    }
+
+    void _Reap(Worker &w)
+    {
+      w.channel.reset();
+      if (w.pid > 0)
+      {
+        int status;
+        while (::waitpid(w.pid, &status, 0) < 0 && errno == EINTR)
+          ;
+      }
+      w.pid = -1;
+    }
+
+    void _StopWorkers()
+    {
+      for (auto &w : _workers)
+      {
+        if (w.channel)
+          w.channel->Send({solve::op::Enum::QUIT});
+        _Reap(w);
+      }
+      _workers.clear();
+    }
+
+    //true if the side to move wins with its next stone or nobody can move, `score` set
+    static bool _Terminal(bits_t own, bits_t mask, int &score) noexcept
+    {
+      using namespace bitboard;
+
+      const int ply = Count(mask);
+      if (Threats(own, mask) & Possible(mask))
+      {
+        score = C4AI::kWin - ply - 1;
+        return true;
+      }
+      if (ply == kCells)
+      {
+        score = 0;
+        return true;
+      }
+      return false;
+    }
+
+    //units for every distinct non terminal position `depth` plies below
+    void _Split(bits_t own, bits_t mask, int depth)
+    {
+      using namespace bitboard;
+
+      int score;
+      if (_Terminal(own, mask, score))
+        return;
+      if (depth == 0)
+      {
+        const std::uint64_t key = Key(own, mask);
+        if (_index.emplace(key, std::uint32_t(_units.size())).second)
+          _units.push_back({key});
+        return;
+      }
+
+      const bits_t possible = Possible(mask);
+      for (int c = 0; c < kCols; ++c)
+        if (possible & Column(c))
+          _Split(own ^ mask, mask | (possible & Column(c)), depth - 1);
+    }
+
+    //negamax over the cut tree with the units' scores at the cut
+    int _Backup(bits_t own, bits_t mask, int depth, int *column) const
+    {
+      using namespace bitboard;
+
+      const bits_t possible = Possible(mask);
+      int score;
+      if (_Terminal(own, mask, score))
+      {
+        if (column)
+          for (int c = 0; c < kCols && *column < 0; ++c)
+            if ((possible & Column(c)) && IsAligned(own | (possible & Column(c))))
+              *column = c;
+        return score;
+      }
+      if (depth == 0)
+        return _units[_index.at(Key(own, mask))].score;
+
+      int top = INT_MIN;
+      for (int c = 0; c < kCols; ++c)
+        if (possible & Column(c))
+        {
+          const int s = -_Backup(own ^ mask, mask | (possible & Column(c)), depth - 1, nullptr);
+          if (s > top)
+          {
+            top = s;
+            if (column)
+              *column = c;
+          }
+        }
+      return top;
+    }
+  };
+} // namespace c4
+
+#endif //__linux__
+
+#endif //C4_SOLVE_H_
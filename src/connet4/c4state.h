@@ -0,0 +1,114 @@
+#ifndef C4_COMPACT_STATE_H_
+#define C4_COMPACT_STATE_H_
+
+#include <cstdint>
+
+#include "c4bitboard.h"
+#include "c4game.h"
+
+namespace c4
+{
+  /**
+   * @brief a whole C4Game in one cache line, no heap
+   * @details stones, heights, turn, result and the piece and level of both seats,
+   * FromGame and ToGame round trip everything but player names and the move history
+   * @code .cpp
+   * C4State s = C4State::FromGame(game);
+   * C4Game g;
+   * g.insert(C4Human{"h", s.level[0], C4Piece{s.piece[0]}});
+   * g.insert(C4AI{"ai", s.level[1], C4Piece{s.piece[1]}});
+   * s.ToGame(g);
+   * @endcode
+   */
+  struct C4State
+  {
+    bitboard::bits_t mask{0};                                  //all stones
+    bitboard::bits_t first{0};                                 //stones of the first mover
+    std::uint8_t height[bitboard::kCols]{};                    //stones per column
+    std::uint8_t ply{0};                                       //stones played
+    std::uint8_t turn{0};                                      //seat to move
+    std::int8_t winner{-1};                                    //seat or -1
+    std::uint8_t state{std::uint8_t(bg::game::Enum::NOTOVER)}; //bg::game::Enum
+    std::int8_t last_mover{-1};                                //seat that placed the last stone
+    char piece[2]{'.', '.'};                                   //piece of each seat
+    std::uint8_t level[2]{0, 0};                               //diff_level of each seat
+    std::uint8_t user{0};                                      //free for the owner, e.g. which seat is remote
+    std::uint8_t first_seat{0};                                //seat of the first mover, or to move on an empty board
+
+    //-----------------------GETTERS-------------------------
+
+    //stones of the side to move
+    inline auto own() const noexcept { return ply & 1 ? first ^ mask : first; }
+    //stones of the side that just moved
+    inline auto opp() const noexcept { return own() ^ mask; }
+    inline auto key() const noexcept { return bitboard::Key(own(), mask); }
+    inline bool IsOver() const noexcept { return state != std::uint8_t(bg::game::Enum::NOTOVER); }
+
+    //-----------------------FUNCTIONS-----------------------
+
+    static C4State FromGame(const C4Game &game)
+    {
+      C4State s;
+      s.mask = game.mask();
+      s.first = game.ply() & 1 ? game.opp() : game.own();
+      s.first_seat = std::uint8_t(game.first_seat());
+      for (int c = 0; c < bitboard::kCols; ++c)
+        s.height[c] = std::uint8_t(game.AvailableRow(std::size_t(c)));
+      s.ply = std::uint8_t(game.ply());
+      s.turn = std::uint8_t(game.turning_player());
+      s.winner = std::int8_t(game.winner());
+      s.state = std::uint8_t(game.state());
+      s.last_mover = std::int8_t(game.last_mover());
+
+      const auto &players = game.players()->data();
+      for (std::size_t seat = 0; seat < 2 && seat < players.size(); ++seat)
+      {
+        s.piece[seat] = players[seat]->pieces().front()->get();
+        s.level[seat] = std::uint8_t(players[seat]->diff_level());
+      }
+      return s;
+    }
+
+    /**
+     * @brief overwrites the position of a game whose players are already seated
+     * @param game
+     */
+    void ToGame(C4Game &game) const { game._Restore(*this); }
+  };
+
+  static_assert(sizeof(C4State) <= 64, "C4State must fit a cache line");
+
+  inline void C4Game::_Restore(const C4State &s)
+  {
+    auto &b = *board();
+    for (int r = 0; r < kRows; ++r)
+      for (int c = 0; c < kCols; ++c)
+        b.erase(std::size_t(r), std::size_t(c));
+
+    for (int c = 0; c < kCols; ++c)
+    {
+      available_row[c] = s.height[c];
+      for (int r = 0; r < s.height[c]; ++r)
+      {
+        const int seat = s.first & bitboard::Cell(r, c) ? s.first_seat : 1 - s.first_seat;
+        b.insert(std::size_t(r), std::size_t(c), *(players()->at(std::size_t(seat))->pieces().front()));
+      }
+    }
+
+    _mask = s.mask;
+    _stones[0] = s.first;
+    _stones[1] = s.first ^ s.mask;
+    _first_seat = s.first_seat;
+    _ply = s.ply;
+    _base = s.ply; //no history before a restored position
+    _last_mover = s.last_mover;
+    _last_won = s.last_mover >= 0 && bitboard::IsAligned(_stones[(s.ply + 1) & 1]);
+    _turning_player = s.turn;
+    _winner = s.winner;
+    _state = bg::game::Enum(s.state);
+    if (_listener.ptr)
+      _listener.ptr->OnReset(*this);
+  }
+} // namespace c4
+
+#endif //C4_COMPACT_STATE_H_
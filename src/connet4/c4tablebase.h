@@ -0,0 +1,595 @@
+#ifndef C4_TABLEBASE_H_
+#define C4_TABLEBASE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../boardgame/bglog.h"
+#include "../boardgame/bgmmap.h"
+#include "../boardgame/bgpool.h"
+#include "c4bitboard.h"
+
+namespace c4
+{
+  /**
+   * @brief exact scores of late positions, one hashed file probed in O(1)
+   * @details a stored score t is 0 for a draw, and for a win of the side to move
+   * kCells + 1 - m where m is the number of the winning stone (-t for a loss),
+   * so faster wins and slower losses score higher
+   * @code .cpp
+   * C4Tablebase tb;
+   * int t;
+   * if (tb.Open("c4.tb") && tb.Probe(own, mask, t))
+   *   use(t);
+   * @endcode
+   */
+  class C4Tablebase
+  {
+  public:
+    static constexpr char kMagic[4] = {'C', '4', 'T', 'B'};
+    static constexpr std::uint32_t kVersion = 1;
+
+    struct Header
+    {
+      char magic[4];
+      std::uint32_t version;
+      std::uint32_t rows;
+      std::uint32_t cols;
+      std::uint32_t min_stones;     //every stored position has at least this many
+      std::uint32_t partition_bits; //table is split in 2^partition_bits independent parts
+      std::uint64_t slots;          //slots per partition, power of two
+      std::uint64_t count;          //positions stored
+    };
+
+    C4Tablebase() = default;
+    explicit C4Tablebase(const std::string &path) { Open(path); }
+
+    //-----------------------GETTERS-------------------------
+
+    inline bool IsOpen() const noexcept { return _table != nullptr; }
+    inline int min_stones() const noexcept { return IsOpen() ? int(_header.min_stones) : bitboard::kCells + 1; }
+    inline auto size() const noexcept { return IsOpen() ? _header.count : 0; }
+
+    //-----------------------FUNCTIONS-----------------------
+
+    /**
+     * @brief maps a file written by C4TablebaseBuilder
+     * @return true | false if missing, from another version or for another board
+     */
+    bool Open(const std::string &path)
+    {
+      _table = nullptr;
+      if (!_file.Open(path) || _file.size() < sizeof(Header))
+        return false;
+
+      std::memcpy(&_header, _file.data(), sizeof(Header));
+      if (std::memcmp(_header.magic, kMagic, 4) || _header.version != kVersion ||
+          _header.rows != bitboard::kRows || _header.cols != bitboard::kCols ||
+          _file.size() != sizeof(Header) + (std::uint64_t{1} << _header.partition_bits) * _header.slots * 8)
+      {
+        BGLOG_WARN("C4Tablebase::Open", "{} is not a tablebase for this build", path);
+        _file.Close();
+        return false;
+      }
+
+      _table = reinterpret_cast<const std::uint64_t *>(_file.data() + sizeof(Header));
+      _file.Advise(true);
+      return true;
+    }
+
+    /**
+     * @brief exact score of a position
+     *
+     * @param own stones of the side to move
+     * @param mask all stones
+     * @param score [out] see the class description
+     * @return true | false if the position is not stored
+     */
+    inline bool Probe(bitboard::bits_t own, bitboard::bits_t mask, int &score) const noexcept
+    {
+      if (!_table || bitboard::Count(mask) < int(_header.min_stones))
+        return false;
+
+      const std::uint64_t key = bitboard::Key(own, mask);
+      const std::uint64_t h = Hash(key);
+      const std::uint64_t *part = _table + Partition(h, _header.partition_bits) * _header.slots;
+      const std::uint64_t slots = _header.slots - 1;
+
+      for (std::uint64_t i = h & slots;; i = (i + 1) & slots)
+      {
+        const std::uint64_t e = part[i];
+        if (!e)
+          return false;
+        if ((e >> 8) == key)
+        {
+          score = int(std::int8_t(e & 0xFF));
+          return true;
+        }
+      }
+    }
+
+    /**
+     * @brief tablebase score in the scale of a search that scores a win as `win` minus the winning stone's number
+     */
+    static inline int ToSearchScore(int t, int win) noexcept
+    {
+      if (t > 0)
+        return win - (bitboard::kCells + 1 - t);
+      if (t < 0)
+        return -(win - (bitboard::kCells + 1 + t));
+      return 0;
+    }
+
+    //----------------------SHARED WITH THE BUILDER------------------
+
+    static inline std::uint64_t Hash(std::uint64_t key) noexcept
+    {
+      key ^= key >> 33;
+      key *= 0xff51afd7ed558ccdull;
+      key ^= key >> 33;
+      key *= 0xc4ceb9fe1a85ec53ull;
+      key ^= key >> 33;
+      return key;
+    }
+
+    static inline std::uint64_t Partition(std::uint64_t hash, std::uint32_t bits) noexcept
+    {
+      return bits ? hash >> (64 - bits) : 0;
+    }
+
+    static inline std::uint64_t Entry(std::uint64_t key, int score) noexcept
+    {
+      return key << 8 | std::uint8_t(std::int8_t(score));
+    }
+
+  private:
+    bg::MappedFile _file;
+    Header _header{};
+    const std::uint64_t *_table{nullptr};
+  };
+
+  /**
+   * @brief writes a C4Tablebase by forward enumeration and retrograde analysis
+   * @details levels (positions with the same number of stones) live in sorted key files,
+   * a level is expanded in parallel into sorted runs that are merged on disk, then scores
+   * are computed from the last level back to `min_stones`, only a memory budget is held in RAM
+   * @note the number of positions below ~30 stones is astronomic, lower `min_stones`
+   * only together with a `root` that starts late in the game
+   */
+  class C4TablebaseBuilder
+  {
+  public:
+    using bits_t = bitboard::bits_t;
+
+    struct Options
+    {
+      std::string dir{"."};                                                //scratch files
+      std::string out{"c4.tb"};                                            //resulting table
+      int min_stones{36};                                                  //smallest level stored
+      unsigned threads{std::max(1u, std::thread::hardware_concurrency())}; //parts of a level run in parallel
+      bg::ThreadPool *pool{nullptr};                                       //nullptr for the shared pool
+      std::size_t memory{std::size_t{256} << 20};                          //bytes of RAM to use at most
+      bits_t root_own{0};                                                  //start position, stones of the side to move
+      bits_t root_mask{0};                                                 //start position, all stones
+    };
+
+    explicit C4TablebaseBuilder(const Options &options) : _o{options} {}
+
+    /**
+     * @brief runs every step, scratch files are removed afterwards
+     * @return true | false on an I/O error
+     */
+    bool Build()
+    {
+      using namespace bitboard;
+
+      const int root = Count(_o.root_mask);
+      const int first = std::max(root, _o.min_stones);
+
+      if (!_WriteKeys(_Level(root), {Key(_o.root_own, _o.root_mask)}))
+        return false;
+
+      for (int k = root; k < kCells; ++k)
+      {
+        if (!_Expand(k))
+          return false;
+        BGLOG_INFO("C4TablebaseBuilder::Build", "level {} -> {} positions", k + 1, _Count(_Level(k + 1)));
+        if (k < first)
+          std::remove(_Level(k).c_str());
+      }
+
+      for (int k = kCells; k >= first; --k)
+        if (!_Solve(k))
+          return false;
+
+      const bool ok = _Write(first);
+      for (int k = first; k <= kCells; ++k)
+      {
+        std::remove(_Level(k).c_str());
+        std::remove(_Values(k).c_str());
+      }
+      return ok;
+    }
+
+  private:
+    inline bg::ThreadPool &_pool() const { return _o.pool ? *_o.pool : bg::ThreadPool::Shared(); }
+
+    //------------------------FILES------------------------------
+
+    inline std::string _Level(int k) const { return _o.dir + "/level_" + std::to_string(k) + ".keys"; }
+    inline std::string _Values(int k) const { return _o.dir + "/level_" + std::to_string(k) + ".vals"; }
+    inline std::string _Run(int k, unsigned t, std::size_t i) const
+    {
+      return _o.dir + "/run_" + std::to_string(k) + "_" + std::to_string(t) + "_" + std::to_string(i);
+    }
+
+    static std::uint64_t _Count(const std::string &path)
+    {
+      std::FILE *f = std::fopen(path.c_str(), "rb");
+      if (!f)
+        return 0;
+      std::fseek(f, 0, SEEK_END);
+      const auto n = std::uint64_t(std::ftell(f)) / 8;
+      std::fclose(f);
+      return n;
+    }
+
+    static bool _WriteKeys(const std::string &path, const std::vector<std::uint64_t> &keys)
+    {
+      std::FILE *f = std::fopen(path.c_str(), "wb");
+      if (!f)
+        return false;
+      const bool ok = std::fwrite(keys.data(), 8, keys.size(), f) == keys.size();
+      return std::fclose(f) == 0 && ok;
+    }
+
+    //------------------------FORWARD----------------------------
+
+    /**
+     * @brief level k+1 = every child of level k that does not end the game
+     */
+    bool _Expand(int k)
+    {
+      using namespace bitboard;
+
+      const std::uint64_t n = _Count(_Level(k));
+      const unsigned threads = unsigned(std::max<std::uint64_t>(1, std::min<std::uint64_t>(_o.threads, n)));
+      const std::size_t budget = std::max<std::size_t>(1 << 16, _o.memory / 8 / threads);
+
+      std::vector<std::vector<std::string>> runs(threads);
+      std::vector<char> ok(threads, 1);
+
+      _pool().ParallelFor(threads, [&](std::size_t t) {
+        const std::uint64_t begin = n * t / threads, end = n * (t + 1) / threads;
+        std::vector<std::uint64_t> children;
+        children.reserve(budget);
+
+        auto flush = [&] {
+          std::sort(children.begin(), children.end());
+          children.erase(std::unique(children.begin(), children.end()), children.end());
+          runs[t].push_back(_Run(k, t, runs[t].size()));
+          ok[t] &= _WriteKeys(runs[t].back(), children);
+          children.clear();
+        };
+
+        _ForEachKey(_Level(k), begin, end, [&](std::uint64_t key) {
+          bits_t own, mask;
+          Decode(key, own, mask);
+          const bits_t opp = own ^ mask;
+          for (bits_t moves = Possible(mask); moves; moves &= moves - 1)
+          {
+            const bits_t cell = moves & (~moves + 1);
+            if (IsAligned(own | cell))
+              continue; //the game is over, nothing to store
+            children.push_back(Key(opp, mask | cell));
+            if (children.size() == budget)
+              flush();
+          }
+        });
+        if (!children.empty())
+          flush();
+      }, bg::priority::Enum::LOW);
+
+      std::vector<std::string> all;
+      for (unsigned t = 0; t < threads; ++t)
+      {
+        if (!ok[t])
+          return false;
+        all.insert(all.end(), runs[t].begin(), runs[t].end());
+      }
+
+      const bool merged = _Merge(all, _Level(k + 1));
+      for (const auto &r : all)
+        std::remove(r.c_str());
+      return merged;
+    }
+
+    //calls fn(key) for keys [begin, end) of a level file
+    template <class Fn>
+    static bool _ForEachKey(const std::string &path, std::uint64_t begin, std::uint64_t end, Fn &&fn)
+    {
+      std::FILE *f = std::fopen(path.c_str(), "rb");
+      if (!f)
+        return false;
+      std::fseek(f, long(begin * 8), SEEK_SET);
+
+      std::vector<std::uint64_t> chunk(1 << 16);
+      for (std::uint64_t at = begin; at < end;)
+      {
+        const std::size_t want = std::size_t(std::min<std::uint64_t>(chunk.size(), end - at));
+        const std::size_t got = std::fread(chunk.data(), 8, want, f);
+        for (std::size_t i = 0; i < got; ++i)
+          fn(chunk[i]);
+        if (got != want)
+          break;
+        at += got;
+      }
+      std::fclose(f);
+      return true;
+    }
+
+    //k-way merge of sorted runs, dropping duplicates
+    static bool _Merge(const std::vector<std::string> &runs, const std::string &out)
+    {
+      struct Source
+      {
+        std::FILE *f;
+        std::vector<std::uint64_t> buf;
+        std::size_t at, n;
+
+        bool Next(std::uint64_t &key)
+        {
+          if (at == n)
+          {
+            n = std::fread(buf.data(), 8, buf.size(), f);
+            at = 0;
+            if (!n)
+              return false;
+          }
+          key = buf[at++];
+          return true;
+        }
+      };
+
+      std::vector<Source> sources;
+      for (const auto &r : runs)
+        if (std::FILE *f = std::fopen(r.c_str(), "rb"))
+          sources.push_back({f, std::vector<std::uint64_t>(1 << 14), 0, 0});
+
+      using Head = std::pair<std::uint64_t, std::size_t>;
+      std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+      for (std::size_t i = 0; i < sources.size(); ++i)
+      {
+        std::uint64_t key;
+        if (sources[i].Next(key))
+          heads.push({key, i});
+      }
+
+      std::FILE *f = std::fopen(out.c_str(), "wb");
+      bool ok = f != nullptr;
+      std::vector<std::uint64_t> buf;
+      buf.reserve(1 << 16);
+      std::uint64_t last = 0;
+
+      while (ok && !heads.empty())
+      {
+        const auto [key, i] = heads.top();
+        heads.pop();
+        if (key != last)
+        {
+          buf.push_back(key);
+          last = key; //keys are never 0
+          if (buf.size() == buf.capacity())
+          {
+            ok = std::fwrite(buf.data(), 8, buf.size(), f) == buf.size();
+            buf.clear();
+          }
+        }
+        std::uint64_t next;
+        if (sources[i].Next(next))
+          heads.push({next, i});
+      }
+
+      if (f)
+      {
+        ok = ok && std::fwrite(buf.data(), 8, buf.size(), f) == buf.size();
+        ok = std::fclose(f) == 0 && ok;
+      }
+      for (auto &s : sources)
+        std::fclose(s.f);
+      return ok;
+    }
+
+    //------------------------BACKWARD---------------------------
+
+    /**
+     * @brief scores of level k from the scores of level k+1
+     */
+    bool _Solve(int k)
+    {
+      using namespace bitboard;
+
+      const std::uint64_t n = _Count(_Level(k));
+      const unsigned threads = unsigned(std::max<std::uint64_t>(1, std::min<std::uint64_t>(_o.threads, n)));
+
+      bg::MappedFile childKeys, childVals;
+      if (k < kCells && (!childKeys.Open(_Level(k + 1)) || !childVals.Open(_Values(k + 1))))
+        return false;
+      const auto *ck = reinterpret_cast<const std::uint64_t *>(childKeys.data());
+      const auto *cv = reinterpret_cast<const std::int8_t *>(childVals.data());
+      const std::size_t cn = childKeys.size() / 8;
+      if (k < kCells && childVals.size() != cn)
+      {
+        BGLOG_WARN("C4TablebaseBuilder::_Solve", "level {} has {} keys and {} scores", k + 1, cn, childVals.size());
+        return false;
+      }
+
+      std::vector<std::string> parts(threads);
+      std::vector<char> ok(threads, 1), missing(threads, 0);
+
+      _pool().ParallelFor(threads, [&](std::size_t t) {
+        const std::uint64_t begin = n * t / threads, end = n * (t + 1) / threads;
+        parts[t] = _Values(k) + "." + std::to_string(t);
+        std::FILE *f = std::fopen(parts[t].c_str(), "wb");
+        if (!f)
+        {
+          ok[t] = 0;
+          return;
+        }
+
+        std::vector<std::int8_t> out;
+        out.reserve(1 << 16);
+        _ForEachKey(_Level(k), begin, end, [&](std::uint64_t key) {
+          bits_t own, mask;
+          Decode(key, own, mask);
+
+          int best = 0;
+          const bits_t moves = Possible(mask);
+          if (Threats(own, mask) & moves)
+            best = kCells - k; //the next stone wins
+          else if (moves)
+          {
+            best = -kCells;
+            for (bits_t m = moves; m; m &= m - 1)
+            {
+              const std::uint64_t child = Key(own ^ mask, mask | (m & (~m + 1)));
+              const auto it = std::lower_bound(ck, ck + cn, child);
+              if (it == ck + cn || *it != child)
+              {
+                ok[t] = 0; //every non losing child is stored, unless the level is truncated or stale
+                missing[t] = 1;
+                return;
+              }
+              best = std::max(best, -int(cv[it - ck]));
+            }
+          }
+
+          out.push_back(std::int8_t(best));
+          if (out.size() == out.capacity())
+          {
+            ok[t] &= std::fwrite(out.data(), 1, out.size(), f) == out.size();
+            out.clear();
+          }
+        });
+        ok[t] &= std::fwrite(out.data(), 1, out.size(), f) == out.size();
+        ok[t] &= std::fclose(f) == 0;
+      }, bg::priority::Enum::LOW);
+
+      if (std::find(missing.begin(), missing.end(), 1) != missing.end())
+        BGLOG_WARN("C4TablebaseBuilder::_Solve", "level {} is missing children of level {}", k + 1, k);
+
+      //concatenate the parts in order
+      std::FILE *f = std::fopen(_Values(k).c_str(), "wb");
+      bool all = f != nullptr;
+      std::vector<char> buf(1 << 20);
+      for (unsigned t = 0; t < threads; ++t)
+      {
+        all = all && ok[t];
+        if (std::FILE *p = std::fopen(parts[t].c_str(), "rb"))
+        {
+          for (std::size_t got; all && (got = std::fread(buf.data(), 1, buf.size(), p));)
+            all = std::fwrite(buf.data(), 1, got, f) == got;
+          std::fclose(p);
+        }
+        std::remove(parts[t].c_str());
+      }
+      return f && std::fclose(f) == 0 && all;
+    }
+
+    //------------------------INDEX------------------------------
+
+    /**
+     * @brief hashes levels first..kCells into the probe file, one partition in RAM at a time
+     */
+    bool _Write(int first)
+    {
+      using namespace bitboard;
+
+      std::uint64_t count = 0;
+      for (int k = first; k <= kCells; ++k)
+        count += _Count(_Level(k));
+
+      //2 slots per position, partitions small enough for the memory budget
+      std::uint64_t total = 16;
+      while (total < count * 2)
+        total <<= 1;
+      std::uint32_t bits = 0;
+      while ((total >> bits) * 8 > _o.memory && bits < 10)
+        ++bits;
+
+      C4Tablebase::Header header{};
+      std::memcpy(header.magic, C4Tablebase::kMagic, 4);
+      header.version = C4Tablebase::kVersion;
+      header.rows = kRows;
+      header.cols = kCols;
+      header.min_stones = std::uint32_t(first);
+      header.partition_bits = bits;
+      header.slots = total >> bits;
+      header.count = count;
+
+      //scatter entries to one bucket file per partition
+      const std::uint32_t parts = 1u << bits;
+      std::vector<std::FILE *> buckets(parts);
+      bool ok = true;
+      for (std::uint32_t p = 0; p < parts; ++p)
+        ok &= (buckets[p] = std::fopen((_o.out + ".part" + std::to_string(p)).c_str(), "wb+")) != nullptr;
+
+      for (int k = first; ok && k <= kCells; ++k)
+      {
+        std::FILE *vals = std::fopen(_Values(k).c_str(), "rb");
+        ok = vals != nullptr;
+        std::vector<std::int8_t> chunk(1 << 16);
+        std::size_t have = 0, at = 0;
+        _ForEachKey(_Level(k), 0, _Count(_Level(k)), [&](std::uint64_t key) {
+          if (at == have)
+          {
+            have = vals ? std::fread(chunk.data(), 1, chunk.size(), vals) : 0;
+            at = 0;
+          }
+          const std::uint64_t e = C4Tablebase::Entry(key, at < have ? chunk[at++] : 0);
+          ok &= std::fwrite(&e, 8, 1, buckets[C4Tablebase::Partition(C4Tablebase::Hash(key), bits)]) == 1;
+        });
+        if (vals)
+          std::fclose(vals);
+      }
+
+      //place every partition with linear probing and append it
+      std::FILE *out = std::fopen(_o.out.c_str(), "wb");
+      ok = ok && out && std::fwrite(&header, sizeof(header), 1, out) == 1;
+      std::vector<std::uint64_t> table;
+      for (std::uint32_t p = 0; p < parts; ++p)
+      {
+        table.assign(header.slots, 0);
+        if (ok)
+        {
+          std::rewind(buckets[p]);
+          std::uint64_t e;
+          while (std::fread(&e, 8, 1, buckets[p]) == 1)
+          {
+            std::uint64_t i = C4Tablebase::Hash(e >> 8) & (header.slots - 1);
+            while (table[i])
+              i = (i + 1) & (header.slots - 1);
+            table[i] = e;
+          }
+          ok = std::fwrite(table.data(), 8, table.size(), out) == table.size();
+        }
+        if (buckets[p])
+          std::fclose(buckets[p]);
+        std::remove((_o.out + ".part" + std::to_string(p)).c_str());
+      }
+      return out && std::fclose(out) == 0 && ok;
+    }
+
+  private:
+    Options _o;
+  };
+} // namespace c4
+
+#endif //C4_TABLEBASE_H_
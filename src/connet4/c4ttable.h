@@ -0,0 +1,263 @@
+#ifndef C4_TTABLE_H_
+#define C4_TTABLE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../boardgame/bglog.h"
+#include "../boardgame/bgmmap.h"
+#include "c4bitboard.h"
+#include "c4tablebase.h"
+
+namespace c4
+{
+  namespace bound
+  {
+    enum class Enum : std::uint8_t
+    {
+      NONE,  //empty slot
+      UPPER, //failed low, the score is at most this
+      LOWER, //failed high, the score is at least this
+      EXACT
+    };
+
+    inline const char *ToString(Enum value) noexcept
+    {
+      switch (value)
+      {
+      case Enum::NONE:
+        return "NONE";
+      case Enum::UPPER:
+        return "UPPER";
+      case Enum::LOWER:
+        return "LOWER";
+      case Enum::EXACT:
+        return "EXACT";
+      }
+      return "UNKNOWN";
+    }
+  } // namespace bound
+
+  /**
+   * @brief scores of searched positions, shared by the searches of every thread
+   * @details a slot is two words, the key xor the data and the data, so a slot torn by
+   * two threads writing at once fails the check instead of returning another position's score
+   * a snapshot file is a Header followed by the slots as they are in memory, so a process can
+   * start with the table of the one it replaces
+   * @note scores of different evaluators do not mix, give every evaluator its own table
+   * and its own snapshot `tag`
+   * @code .cpp
+   * auto tt = std::make_shared<C4TTable>(64);
+   * tt->Load("engine.tt"); //warm start, fine if missing
+   * ai.set_ttable(tt);
+   * //...
+   * tt->Save("engine.tt");
+   * @endcode
+   */
+  class C4TTable
+  {
+  public:
+    static constexpr char kMagic[4] = {'C', '4', 'T', 'T'};
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::uint32_t kHashScheme = 1; //bitboard::Key hashed by C4Tablebase::Hash, bump if either changes
+
+    struct Header
+    {
+      char magic[4];
+      std::uint32_t version;
+      std::uint32_t hash_scheme;
+      std::uint32_t rows;
+      std::uint32_t cols;
+      std::uint32_t slot_size;
+      std::uint64_t slots; //power of two
+      std::uint64_t tag;   //the owner's, e.g. a hash of the evaluator weights
+    };
+
+    struct Entry
+    {
+      int score{0};
+      int depth{0};                         //plies searched below the position
+      bound::Enum bound{bound::Enum::NONE};
+      int best{-1};                         //column, -1 if none
+    };
+
+    /**
+     * @param megabytes rounded down to a power of two slots, at least 1024 slots
+     */
+    explicit C4TTable(std::size_t megabytes = 16)
+    {
+      std::size_t n = 1024;
+      while (n * 2 * sizeof(Slot) <= megabytes << 20)
+        n *= 2;
+      _slots.reset(new Slot[n]);
+      _mask = n - 1;
+    }
+
+    C4TTable(const C4TTable &) = delete;
+    C4TTable &operator=(const C4TTable &) = delete;
+
+    //-----------------------GETTERS-------------------------
+
+    inline std::size_t size() const noexcept { return std::size_t(_mask + 1); }
+    inline std::size_t bytes() const noexcept { return size() * sizeof(Slot); }
+
+    //-----------------------FUNCTIONS-----------------------
+
+    /**
+     * @param key bitboard::Key of the position
+     * @param e [out]
+     * @return true | false if the position is not stored
+     */
+    inline bool Probe(std::uint64_t key, Entry &e) const noexcept
+    {
+      const Slot &s = _slots[_Index(key)];
+      const std::uint64_t check = s.check.load(std::memory_order_relaxed);
+      const std::uint64_t data = s.data.load(std::memory_order_relaxed);
+      if ((check ^ data) != key || !data)
+        return false;
+      e = _Unpack(data);
+      return true;
+    }
+
+    //keeps a deeper result of the same position
+    inline void Store(std::uint64_t key, int score, int depth, bound::Enum b, int best) noexcept
+    {
+      Slot &s = _slots[_Index(key)];
+      const std::uint64_t old = s.data.load(std::memory_order_relaxed);
+      if ((s.check.load(std::memory_order_relaxed) ^ old) == key && old && _Unpack(old).depth > depth)
+        return;
+
+      const std::uint64_t data = _Pack(score, depth, b, best);
+      s.check.store(key ^ data, std::memory_order_relaxed);
+      s.data.store(data, std::memory_order_relaxed);
+    }
+
+    void Clear() noexcept
+    {
+      for (std::size_t i = 0; i < size(); ++i)
+      {
+        _slots[i].check.store(0, std::memory_order_relaxed);
+        _slots[i].data.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    //-----------------------SNAPSHOTS-----------------------
+
+    /**
+     * @brief writes the table, safe while searches run, a slot they tear is dropped on Load
+     * @details written next to `path` and renamed over it, so readers never see half a file
+     * @return true | false on an I/O error
+     */
+    bool Save(const std::string &path, std::uint64_t tag = 0) const
+    {
+      const std::string tmp = path + ".tmp";
+      std::FILE *f = std::fopen(tmp.c_str(), "wb");
+      if (!f)
+        return false;
+
+      Header h{};
+      std::memcpy(h.magic, kMagic, 4);
+      h.version = kVersion;
+      h.hash_scheme = kHashScheme;
+      h.rows = bitboard::kRows;
+      h.cols = bitboard::kCols;
+      h.slot_size = sizeof(Slot);
+      h.slots = size();
+      h.tag = tag;
+      bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+
+      //copied out a chunk at a time, the slots are atomics
+      std::vector<std::uint64_t> chunk(std::size_t{2} << 15);
+      for (std::size_t i = 0; ok && i < size();)
+      {
+        std::size_t n = 0;
+        for (; n < chunk.size() && i < size(); n += 2, ++i)
+        {
+          chunk[n] = _slots[i].check.load(std::memory_order_relaxed);
+          chunk[n + 1] = _slots[i].data.load(std::memory_order_relaxed);
+        }
+        ok = std::fwrite(chunk.data(), 8, n, f) == n;
+      }
+
+      ok = std::fclose(f) == 0 && ok;
+      if (ok)
+        ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+      if (!ok)
+        std::remove(tmp.c_str());
+      return ok;
+    }
+
+    /**
+     * @brief adds the entries of a snapshot, which may have been saved by a table of another size
+     * @return true | false if missing, damaged, for another board, hash scheme or tag
+     */
+    bool Load(const std::string &path, std::uint64_t tag = 0)
+    {
+      bg::MappedFile file;
+      if (!file.Open(path) || file.size() < sizeof(Header))
+        return false;
+
+      Header h;
+      std::memcpy(&h, file.data(), sizeof(h));
+      if (std::memcmp(h.magic, kMagic, 4) || h.version != kVersion || h.hash_scheme != kHashScheme ||
+          h.rows != bitboard::kRows || h.cols != bitboard::kCols || h.slot_size != sizeof(Slot) || h.tag != tag ||
+          file.size() != sizeof(Header) + h.slots * sizeof(Slot))
+      {
+        BGLOG_WARN("C4TTable::Load", "{} is not a snapshot for this build", path);
+        return false;
+      }
+      file.Advise(false);
+
+      const auto *words = reinterpret_cast<const std::uint64_t *>(file.data() + sizeof(Header));
+      std::uint64_t loaded = 0;
+      for (std::uint64_t i = 0; i < h.slots; ++i)
+      {
+        const std::uint64_t check = words[2 * i], data = words[2 * i + 1], key = check ^ data;
+        bitboard::bits_t own, mask;
+        bitboard::Decode(key, own, mask);
+        if (!data || bitboard::Key(own, mask) != key)
+          continue; //empty, or torn while it was saved
+        const Entry e = _Unpack(data);
+        Store(key, e.score, e.depth, e.bound, e.best);
+        ++loaded;
+      }
+      BGLOG_INFO("C4TTable::Load", "{} entries from {}", loaded, path);
+      return true;
+    }
+
+  protected:
+    struct Slot
+    {
+      std::atomic<std::uint64_t> check{0}; //key ^ data
+      std::atomic<std::uint64_t> data{0};  //score:32 depth:8 bound:8 best+1:8, 0 if empty
+    };
+
+    static_assert(sizeof(Slot) == 16 && std::atomic<std::uint64_t>::is_always_lock_free,
+                  "snapshots store slots as two plain words");
+    static_assert(sizeof(Header) % 8 == 0, "slots must stay aligned in a mapped snapshot");
+
+    std::unique_ptr<Slot[]> _slots;
+    std::uint64_t _mask{0};
+
+    inline std::uint64_t _Index(std::uint64_t key) const noexcept { return C4Tablebase::Hash(key) & _mask; }
+
+    static inline std::uint64_t _Pack(int score, int depth, bound::Enum b, int best) noexcept
+    {
+      return std::uint64_t(std::uint32_t(score)) | std::uint64_t(std::uint8_t(depth)) << 32 |
+             std::uint64_t(b) << 40 | std::uint64_t(std::uint8_t(best + 1)) << 48;
+    }
+
+    static inline Entry _Unpack(std::uint64_t data) noexcept
+    {
+      return {int(std::int32_t(std::uint32_t(data))), int(std::uint8_t(data >> 32)),
+              bound::Enum(std::uint8_t(data >> 40)), int(std::uint8_t(data >> 48)) - 1};
+    }
+  };
+} // namespace c4
+
+#endif //C4_TTABLE_H_
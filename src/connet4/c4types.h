@@ -9,6 +9,7 @@ using C4Move = ::bg::Move<char>;
 using C4Piece = ::bg::Piece<char>;
 using C4Pieces = ::bg::Pieces<char>;
 using C4Board = ::bg::PBoard<char>;
+using C4SparseBoard = ::bg::SparseBoard<C4Piece>;
 using BGame = ::bg::Game<char>;
 
 #endif //C4_TYPES_H_
\ No newline at end of file
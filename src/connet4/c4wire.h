@@ -0,0 +1,118 @@
+#ifndef C4_WIRE_H_
+#define C4_WIRE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace c4
+{
+  /* server protocol, every message both ways is one 8 byte frame
+     byte 0     op
+     byte 1     arg     (level, column or error code)
+     byte 2     aux     (first mover or game status)
+     byte 3     0
+     byte 4..7  session id, little endian
+  */
+  namespace wire
+  {
+    constexpr std::size_t kFrame = 8;
+    constexpr std::uint8_t kNoColumn = 0xFF;
+
+    namespace op
+    {
+      enum class Enum : std::uint8_t
+      {
+        NEW = 0x01,  //client: arg = engine level, aux = 1 if the engine moves first
+        MOVE = 0x02, //client: arg = column 0..6
+        END = 0x03,  //client: drops the session
+        PING = 0x04,
+
+        STARTED = 0x81, //server: session created
+        MOVED = 0x82,   //server: arg = engine column or kNoColumn, aux = status
+        ENDED = 0x83,   //server: session dropped
+        PONG = 0x84,
+        ERROR = 0xFF, //server: arg = error
+      };
+
+      inline const char *ToString(Enum value) noexcept
+      {
+        switch (value)
+        {
+        case Enum::NEW:
+          return "NEW";
+        case Enum::MOVE:
+          return "MOVE";
+        case Enum::END:
+          return "END";
+        case Enum::PING:
+          return "PING";
+        case Enum::STARTED:
+          return "STARTED";
+        case Enum::MOVED:
+          return "MOVED";
+        case Enum::ENDED:
+          return "ENDED";
+        case Enum::PONG:
+          return "PONG";
+        case Enum::ERROR:
+          return "ERROR";
+        }
+        return "UNKNOWN";
+      }
+    } // namespace op
+
+    namespace status
+    {
+      enum class Enum : std::uint8_t
+      {
+        NOTOVER,
+        CLIENT_WON,
+        ENGINE_WON,
+        DRAW,
+      };
+    } // namespace status
+
+    namespace error
+    {
+      enum class Enum : std::uint8_t
+      {
+        BAD_OP = 1,
+        NO_SESSION,
+        BUSY,         //the engine is still thinking
+        ILLEGAL_MOVE, //column full, out of range or game over
+        FULL,         //too many sessions
+      };
+    } // namespace error
+
+    struct Frame
+    {
+      op::Enum op{op::Enum::PING};
+      std::uint8_t arg{0};
+      std::uint8_t aux{0};
+      std::uint32_t session{0};
+    };
+
+    inline void Encode(const Frame &f, unsigned char *out) noexcept
+    {
+      out[0] = std::uint8_t(f.op);
+      out[1] = f.arg;
+      out[2] = f.aux;
+      out[3] = 0;
+      for (int i = 0; i < 4; ++i)
+        out[4 + i] = std::uint8_t(f.session >> (8 * i));
+    }
+
+    inline Frame Decode(const unsigned char *in) noexcept
+    {
+      Frame f;
+      f.op = op::Enum(in[0]);
+      f.arg = in[1];
+      f.aux = in[2];
+      for (int i = 0; i < 4; ++i)
+        f.session |= std::uint32_t(in[4 + i]) << (8 * i);
+      return f;
+    }
+  } // namespace wire
+} // namespace c4
+
+#endif //C4_WIRE_H_
@@ -3,21 +3,197 @@
 #include "c4human.h"
 #include "c4game.h"
 #include "../boardgame/bgmove.h"
-#include "../boardgame/bgprint.h"
+#include "../boardgame/bgrender.h"
+#include "c4server.h"
+#include "c4solve.h"
+#include "c4bench.h"
+#include "c4match.h"
+#include <cstring>
+#include <csignal>
+#include <string>
 using namespace std;
 using namespace bg;
 using namespace c4;
 
+//allocation counts for --micro
+BG_BENCH_ALLOCATOR;
 
-int main()
+#if defined(__linux__)
+//Ctrl-C and SIGTERM end Run, which saves the table snapshot
+static C4Server* running = nullptr;
+static void stop_server(int) { if (running) running->Stop(); }
+#endif
+
+
+int main(int argc, char** argv)
 {
+#if defined(__linux__)
+	//c4 --server [port | unix socket path] [table snapshot] [tablebase]
+	if (argc > 1 && !strcmp(argv[1], "--server"))
+	{
+		C4Server::Options o;
+		if (argc > 2)
+		{
+			if (argv[2][0] >= '0' && argv[2][0] <= '9')
+				o.port = static_cast<uint16_t>(stoi(argv[2]));
+			else
+				o.unix_path = argv[2];
+		}
+		if (argc > 3)
+		{
+			o.tt_path = argv[3];
+			o.tt_save_seconds = 300;
+		}
+		if (argc > 4)
+			o.tb_path = argv[4];
+		C4Server server{ o };
+		if (!server.Listen())
+			return 1;
+		running = &server;
+		signal(SIGINT, stop_server);
+		signal(SIGTERM, stop_server);
+		server.Run();
+		running = nullptr;
+		return 0;
+	}
+
+	//c4 --solve [moves] [workers] [split depth], exact score of the position after 1 based `moves`
+	if (argc > 1 && !strcmp(argv[1], "--solve"))
+	{
+		C4SolveCoordinator::Options o;
+		o.program = "/proc/self/exe";
+		if (argc > 3)
+			o.workers = static_cast<size_t>(stoi(argv[3]));
+		if (argc > 4)
+			o.split_depth = stoi(argv[4]);
+		const C4Game game = C4BenchGame(argc > 2 ? argv[2] : "");
+		C4SolveCoordinator solver{ o };
+		const C4SolveCoordinator::Result r = solver.Solve(game.own(), game.mask());
+		if (!r.ok)
+			return 1;
+		printf("column %d score %d nodes %llu units %zu restarts %zu\n", r.column + 1, r.score,
+			static_cast<unsigned long long>(r.nodes), r.units, r.restarts);
+		return 0;
+	}
+
+	//c4 --solve-worker <fd> [megabytes], started by --solve
+	if (argc > 2 && !strcmp(argv[1], "--solve-worker"))
+	{
+		C4FdChannel channel{ stoi(argv[2]) };
+		C4SolveWorker worker{ argc > 3 ? static_cast<size_t>(stoi(argv[3])) : 64 };
+		return worker.Serve(channel) ? 0 : 1;
+	}
+
+	//c4 --loopback [sessions] [level], games through C4Client against a C4Server, exit code 1 on a protocol error
+	if (argc > 1 && !strcmp(argv[1], "--loopback"))
+	{
+		logging::SetLevel(logging::Enum::INFO);
+		return C4BenchLoopback(argc > 2 ? static_cast<size_t>(stoi(argv[2])) : 4, argc > 3 ? stoi(argv[3]) : 4) ? 0 : 1;
+	}
+#endif
+
+	//c4 --bench [depth]
+	if (argc > 1 && !strcmp(argv[1], "--bench"))
+	{
+		C4BenchDrivers(argc > 2 ? static_cast<size_t>(stoi(argv[2])) : 10);
+		return 0;
+	}
+
+	//c4 --analyze [moves] [depth] [tablebase], every column scored, printed as each one is done
+	if (argc > 1 && !strcmp(argv[1], "--analyze"))
+	{
+		logging::SetLevel(logging::Enum::WARN);
+		const C4Game game = C4BenchGame(argc > 2 ? argv[2] : "");
+		C4AI ai{ "analysis", argc > 3 ? static_cast<size_t>(stoi(argv[3])) : 10 };
+		ai.set_driver(driver::Enum::MTDF, 64);
+		C4Tablebase tb;
+		if (argc > 4 && !tb.Open(argv[4]))
+			return 1;
+		ai.set_tablebase(tb.IsOpen() ? &tb : nullptr);
+		ai.Analyze(game, [](const C4AI::Line& line) {
+			printf("column %d score %d depth %d pv", line.column + 1, line.score, line.depth);
+			for (const int c : line.pv)
+				printf(" %d", c + 1);
+			printf("\n");
+			fflush(stdout);
+		});
+		return 0;
+	}
+
+	//c4 --tablebase [moves] [min stones] [file], every position from the one after 1 based `moves`
+	//with at least `min stones` solved into a file --server and --analyze can load
+	if (argc > 1 && !strcmp(argv[1], "--tablebase"))
+	{
+		logging::SetLevel(logging::Enum::INFO);
+		const C4Game game = C4BenchGame(argc > 2 ? argv[2] : "");
+		C4TablebaseBuilder::Options o;
+		o.root_own = game.own();
+		o.root_mask = game.mask();
+		if (argc > 3)
+			o.min_stones = stoi(argv[3]);
+		if (argc > 4)
+			o.out = argv[4];
+		if (!C4TablebaseBuilder{ o }.Build())
+			return 1;
+		const C4Tablebase tb{ o.out };
+		printf("%s positions %llu from %d stones\n", o.out.c_str(), static_cast<unsigned long long>(tb.size()),
+			tb.min_stones());
+		return tb.IsOpen() ? 0 : 1;
+	}
+
+	//c4 --match [max pairs] [first level] [second level] [move ms], stops once the SPRT decides
+	if (argc > 1 && !strcmp(argv[1], "--match"))
+	{
+		logging::SetLevel(logging::Enum::WARN);
+		C4Match::Options o;
+		if (argc > 2)
+			o.max_pairs = static_cast<size_t>(stoi(argv[2]));
+		o.first.name = "first";
+		o.second.name = "second";
+		o.first.level = argc > 3 ? static_cast<size_t>(stoi(argv[3])) : 8;
+		o.second.level = argc > 4 ? static_cast<size_t>(stoi(argv[4])) : 8;
+		o.first.move_ms = o.second.move_ms = argc > 5 ? static_cast<uint64_t>(stoi(argv[5])) : 0;
+		const C4Match::Result r = C4Match{ o }.Run();
+		printf("%s pairs %zu w %llu d %llu l %llu llr %.2f [%.2f %.2f] elo %.1f +- %.1f ms %llu\n",
+			sprt::ToString(r.decision), r.pairs, static_cast<unsigned long long>(r.wins),
+			static_cast<unsigned long long>(r.draws), static_cast<unsigned long long>(r.losses), r.llr, r.lower,
+			r.upper, r.elo, r.elo_error, static_cast<unsigned long long>(r.ms));
+		return 0;
+	}
+
+	//c4 --micro [json file], ns and heap allocations per framework primitive
+	//exits with 2 if a move (an entry named with &&) allocated
+	if (argc > 1 && !strcmp(argv[1], "--micro"))
+	{
+		logging::SetSink(stderr); //stdout is the JSON
+		const auto results = C4BenchPrimitives();
+		const string json = bench::Json(results);
+		FILE* out = argc > 2 ? fopen(argv[2], "w") : stdout;
+		if (!out)
+			return 1;
+		fputs(json.c_str(), out);
+		if (out != stdout)
+			fclose(out);
+
+		int status = 0;
+		for (const auto& r : results)
+			if (r.name.find("&&") != string::npos && r.allocs != 0)
+			{
+				fprintf(stderr, "%s allocates %g per operation\n", r.name.c_str(), r.allocs);
+				status = 2;
+			}
+		return status;
+	}
+
 	C4Game* State = new C4Game();
 
 	State->insert(C4Human{ "human", 4, C4Piece{ 'H' } });
 	State->insert(C4Human{ "human4", 4, C4Piece{ 'K' } });
 
+	Renderer<C4Piece> view{ stdout, render::Enum::FULL, true };
+	view.Draw(*State->board());
 	while(State->MakeMove())
-	//print(State->board());
+		view.Draw(*State->board());
 
 	return 0;
 }